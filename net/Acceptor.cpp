@@ -9,12 +9,16 @@
 
 using namespace muduo;
 using namespace muduo::net;
-Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr)
+Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
     : loop_(loop),
-    acceptSocket_(sockets::createNonblockingOrDie()),
+    acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),
     acceptChannel_(loop, acceptSocket_.fd()),
-    listenning_(false){
+    listenning_(false),
+    deferAcceptSeconds_(0),
+    fastOpenQueueLength_(0){
     acceptSocket_.setReuseAddr(true);
+    //SO_REUSEPORT必须在bind之前设置
+    acceptSocket_.setReusePort(reuseport);
     acceptSocket_.bindAddress(listenAddr);
     acceptChannel_.setReadCallback(boost::bind(&Acceptor::handleRead, this));
 }
@@ -22,6 +26,14 @@ void Acceptor::listen()
 {
     loop_->assertInLoopThread();
     listenning_ = true;
+    if (deferAcceptSeconds_ > 0)
+    {
+        acceptSocket_.setDeferAccept(deferAcceptSeconds_);
+    }
+    if (fastOpenQueueLength_ > 0)
+    {
+        acceptSocket_.setFastOpen(fastOpenQueueLength_);
+    }
     acceptSocket_.listen();
     acceptChannel_.enableReading();
 }
@@ -27,12 +27,16 @@ class Acceptor : noncopyable
 {
 public:
     typedef boost::function<void (int sockfd,const InetAddress&)> NewConnectionCallback;
-    Acceptor(EventLoop* loop, const InetAddress& listenAddr);
+    Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport = false);
     void setNewConnectionCallback(const NewConnectionCallback& cb)
     { newConnectionCallback_ = cb; }
     bool listenning() const { return listenning_; }
     void listen();
 
+    //以下两项在listen()时设置到监听socket上，0表示不设置
+    void setDeferAccept(int seconds) { deferAcceptSeconds_ = seconds; }
+    void setFastOpen(int queueLength) { fastOpenQueueLength_ = queueLength; }
+
 private:
     void handleRead();
 
@@ -41,6 +45,8 @@ private:
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
     bool listenning_;
+    int deferAcceptSeconds_;
+    int fastOpenQueueLength_;
 };
 }//net
 }//muduo
@@ -6,6 +6,10 @@
 #include <memory.h>
 #include <sys/uio.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace muduo;
 using namespace muduo::net;
 /*
@@ -38,4 +42,101 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
         append(extrabuf, n - writable);
     }
     return n;
-}
\ No newline at end of file
+}
+namespace
+{
+typedef const char* (*FindByteFunc)(const char* p, const char* end, char c);
+
+const char* findByteScalar(const char* p, const char* end, char c)
+{
+    return static_cast<const char*>(::memchr(p, c, end - p));
+}
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+/*
+一次比较16个字节，比较结果压缩成16位的掩码，最低的置位就是第一个匹配的位置。
+loadu不要求对齐，也不会越过end读取
+*/
+const char* findByteSse2(const char* p, const char* end, char c)
+{
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findByteScalar(p, end, c);
+}
+
+__attribute__((target("avx2")))
+const char* findByteAvx2(const char* p, const char* end, char c)
+{
+    const __m256i needle = _mm256_set1_epi8(c);
+    while (end - p >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findByteSse2(p, end, c);
+}
+
+FindByteFunc selectFindByte()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return findByteAvx2;
+    }
+    return findByteSse2;
+}
+#else
+FindByteFunc selectFindByte()
+{
+    return findByteScalar;
+}
+#endif
+
+//第一次调用时按CPU选定实现，函数内的static保证多线程下只初始化一次
+const char* findByte(const char* p, const char* end, char c)
+{
+    static const FindByteFunc func = selectFindByte();
+    return func(p, end, c);
+}
+}
+
+const char* Buffer::find(char c, const char* start) const
+{
+    assert(peek() <= start);
+    assert(start <= beginWrite());
+    return findByte(start, beginWrite(), c);
+}
+/*
+查找'\n'再检查前一个字节，这样上一次扫描末尾的'\r'与新到达的'\n'也能配对，
+从beginWrite()处继续查找即可
+*/
+const char* Buffer::findCRLF(const char* start) const
+{
+    assert(peek() <= start);
+    assert(start <= beginWrite());
+    const char* end = beginWrite();
+    const char* p = start;
+    while ((p = findByte(p, end, '\n')) != NULL)
+    {
+        if (p > peek() && p[-1] == '\r')
+        {
+            return p - 1;
+        }
+        ++p;
+    }
+    return NULL;
+}
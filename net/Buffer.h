@@ -2,12 +2,15 @@
 #define MUDUO_NET_BUFFER_H
 
 #include "../base/copyable.h"
+#include "SocketsOps.h"
 
 #include <algorithm>
 #include <string>
 #include <vector>
 
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>  // memcpy
 //#include <unistd.h>  // ssize_t
 
 namespace muduo
@@ -56,6 +59,25 @@ public:
         assert(len <= readableBytes());
         readerIndex_ += len;
     }
+    /*
+    以下查找函数找不到时返回NULL，内部用SSE2/AVX2一次比较16/32字节(运行时按CPU选择)。
+    带start参数的版本从start开始查找，start必须在[peek(), beginWrite()]之内：
+    数据不完整时记下已扫描的长度(比如readableBytes())，新数据到达后从peek()+这个长度继续，
+    不必重新扫描前面的部分。记长度而不是指针，因为append可能让buffer重新分配
+    */
+    //返回"\r\n"中'\r'的位置。从start继续查找时，start前一个字节的'\r'也会被匹配到
+    const char* findCRLF() const
+    { return findCRLF(peek()); }
+    const char* findCRLF(const char* start) const;
+    //返回'\n'的位置
+    const char* findEOL() const
+    { return find('\n', peek()); }
+    const char* findEOL(const char* start) const
+    { return find('\n', start); }
+    const char* find(char c) const
+    { return find(c, peek()); }
+    const char* find(char c, const char* start) const;
+
     void retrieveUntil(const char* end)
     {
         assert(peek() <= end);
@@ -73,6 +95,10 @@ public:
         retrieveAll();
         return str;
     }
+    void retrieveInt64() { retrieve(sizeof(int64_t)); }
+    void retrieveInt32() { retrieve(sizeof(int32_t)); }
+    void retrieveInt16() { retrieve(sizeof(int16_t)); }
+    void retrieveInt8() { retrieve(sizeof(int8_t)); }
     //向buffer中添加数据
     void append(const std::string& str)
     {
@@ -105,6 +131,201 @@ public:
 
     void hasWritten(size_t len)
     { writerIndex_ += len; }
+
+    /*
+    以下整数都以网络字节序(大端)存放。
+    数据在buffer中不一定对齐，一律用memcpy读写，编译器会把定长的memcpy优化成一次load/store，
+    再加上一条bswap
+    */
+    ///
+    /// Append int64_t using network endian
+    ///
+    void appendInt64(int64_t x)
+    {
+        int64_t be64 = sockets::hostToNetwork64(x);
+        append(&be64, sizeof be64);
+    }
+    ///
+    /// Append int32_t using network endian
+    ///
+    void appendInt32(int32_t x)
+    {
+        int32_t be32 = sockets::hostToNetwork32(x);
+        append(&be32, sizeof be32);
+    }
+    void appendInt16(int16_t x)
+    {
+        int16_t be16 = sockets::hostToNetwork16(x);
+        append(&be16, sizeof be16);
+    }
+    void appendInt8(int8_t x)
+    {
+        append(&x, sizeof x);
+    }
+
+    ///
+    /// Read int64_t from network endian
+    ///
+    /// Require: buf->readableBytes() >= sizeof(int64_t)
+    int64_t readInt64()
+    {
+        int64_t result = peekInt64();
+        retrieveInt64();
+        return result;
+    }
+    ///
+    /// Read int32_t from network endian
+    ///
+    /// Require: buf->readableBytes() >= sizeof(int32_t)
+    int32_t readInt32()
+    {
+        int32_t result = peekInt32();
+        retrieveInt32();
+        return result;
+    }
+    int16_t readInt16()
+    {
+        int16_t result = peekInt16();
+        retrieveInt16();
+        return result;
+    }
+    int8_t readInt8()
+    {
+        int8_t result = peekInt8();
+        retrieveInt8();
+        return result;
+    }
+
+    ///
+    /// Peek int64_t from network endian
+    ///
+    /// Require: buf->readableBytes() >= sizeof(int64_t)
+    int64_t peekInt64() const
+    {
+        assert(readableBytes() >= sizeof(int64_t));
+        int64_t be64 = 0;
+        ::memcpy(&be64, peek(), sizeof be64);
+        return sockets::networkToHost64(be64);
+    }
+    ///
+    /// Peek int32_t from network endian
+    ///
+    /// Require: buf->readableBytes() >= sizeof(int32_t)
+    int32_t peekInt32() const
+    {
+        assert(readableBytes() >= sizeof(int32_t));
+        int32_t be32 = 0;
+        ::memcpy(&be32, peek(), sizeof be32);
+        return sockets::networkToHost32(be32);
+    }
+    int16_t peekInt16() const
+    {
+        assert(readableBytes() >= sizeof(int16_t));
+        int16_t be16 = 0;
+        ::memcpy(&be16, peek(), sizeof be16);
+        return sockets::networkToHost16(be16);
+    }
+    int8_t peekInt8() const
+    {
+        assert(readableBytes() >= sizeof(int8_t));
+        int8_t x = *peek();
+        return x;
+    }
+
+    ///
+    /// Prepend int64_t using network endian
+    ///
+    void prependInt64(int64_t x)
+    {
+        int64_t be64 = sockets::hostToNetwork64(x);
+        prepend(&be64, sizeof be64);
+    }
+    ///
+    /// Prepend int32_t using network endian
+    ///
+    void prependInt32(int32_t x)
+    {
+        int32_t be32 = sockets::hostToNetwork32(x);
+        prepend(&be32, sizeof be32);
+    }
+    void prependInt16(int16_t x)
+    {
+        int16_t be16 = sockets::hostToNetwork16(x);
+        prepend(&be16, sizeof be16);
+    }
+    void prependInt8(int8_t x)
+    {
+        prepend(&x, sizeof x);
+    }
+
+    /*
+    varint与protobuf的编码相同：每字节低7位是数据，最高位为1表示后面还有字节，小端在前。
+    64位的值最多占kMaxVarintLen64字节
+    */
+    static const size_t kMaxVarintLen64 = 10;
+    void appendVarint64(uint64_t x)
+    {
+        ensureWritableBytes(kMaxVarintLen64);
+        hasWritten(encodeVarint64(x, beginWrite()) - beginWrite());
+    }
+    ///
+    /// Append n varints, only one capacity check for the whole batch.
+    ///
+    void appendVarints(const uint64_t* values, size_t n)
+    {
+        ensureWritableBytes(n * kMaxVarintLen64);
+        char* p = beginWrite();
+        for (size_t i = 0; i < n; ++i)
+        {
+            p = encodeVarint64(values[i], p);
+        }
+        hasWritten(p - beginWrite());
+    }
+    ///
+    /// Peek a varint.
+    ///
+    /// returns bytes used (> 0), 0 if more data is needed, -1 if malformed
+    int peekVarint64(uint64_t* value) const
+    {
+        const char* end = decodeVarint64(peek(), beginWrite(), value);
+        if (end == NULL)
+        {
+            return readableBytes() >= kMaxVarintLen64 ? -1 : 0;
+        }
+        return static_cast<int>(end - peek());
+    }
+    ///
+    /// Read a varint, returns false and retrieves nothing if it is incomplete or malformed.
+    ///
+    bool readVarint64(uint64_t* value)
+    {
+        int n = peekVarint64(value);
+        if (n > 0)
+        {
+            retrieve(n);
+        }
+        return n > 0;
+    }
+    ///
+    /// Read up to n complete varints, returns the number read.
+    ///
+    size_t readVarints(uint64_t* values, size_t n)
+    {
+        const char* p = peek();
+        const char* end = beginWrite();
+        size_t i = 0;
+        for (; i < n; ++i)
+        {
+            const char* next = decodeVarint64(p, end, &values[i]);
+            if (next == NULL)
+            {
+                break;
+            }
+            p = next;
+        }
+        retrieveUntil(p);
+        return i;
+    }
     //往预留区添加len数据
     void prepend(const void* /*restrict*/ data, size_t len)
     {
@@ -120,9 +341,40 @@ public:
         std::copy(peek(), peek()+readableBytes(), buf.begin()+kCheapPrepend);
         buf.swap(buffer_);
     }
+    //底层vector的容量
+    size_t internalCapacity() const
+    { return buffer_.capacity(); }
     //从套接字读取数据到buffer
     ssize_t readFd(int fd, int* savedErrno);
 private:
+    //p至少有kMaxVarintLen64字节的空间，返回写完后的位置
+    static char* encodeVarint64(uint64_t x, char* p)
+    {
+        while (x >= 0x80)
+        {
+            *p++ = static_cast<char>(x | 0x80);
+            x >>= 7;
+        }
+        *p++ = static_cast<char>(x);
+        return p;
+    }
+    //[p, end)中不是一个完整的varint，或者超过kMaxVarintLen64字节时返回NULL
+    static const char* decodeVarint64(const char* p, const char* end, uint64_t* value)
+    {
+        uint64_t result = 0;
+        for (unsigned shift = 0; shift < 7 * kMaxVarintLen64 && p < end; shift += 7)
+        {
+            uint64_t byte = static_cast<unsigned char>(*p++);
+            result |= (byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                *value = result;
+                return p;
+            }
+        }
+        return NULL;
+    }
+
     char* begin()
     { return &*buffer_.begin(); }
 
@@ -0,0 +1,51 @@
+#include "BufferPool.h"
+
+#include <utility>
+
+using namespace muduo;
+using namespace muduo::net;
+
+BufferPool::BufferPool(size_t maxFree, size_t maxCapacity)
+  : maxFree_(maxFree),
+    maxCapacity_(maxCapacity)
+{
+}
+
+BufferPool::~BufferPool()
+{
+}
+
+Buffer BufferPool::take()
+{
+    {
+        MutexLockGuard lock(mutex_);
+        if (!free_.empty())
+        {
+            //移动只交换vector的指针，不分配内存
+            Buffer buf(std::move(free_.back()));
+            free_.pop_back();
+            return buf;
+        }
+    }
+    return Buffer();
+}
+
+void BufferPool::recycle(Buffer&& buf)
+{
+    if (buf.internalCapacity() > maxCapacity_)
+    {
+        return;
+    }
+    buf.retrieveAll();
+    MutexLockGuard lock(mutex_);
+    if (free_.size() < maxFree_)
+    {
+        free_.push_back(std::move(buf));
+    }
+}
+
+size_t BufferPool::freeBuffers() const
+{
+    MutexLockGuard lock(mutex_);
+    return free_.size();
+}
@@ -0,0 +1,50 @@
+/*
+空闲Buffer的缓存，每个EventLoop一个，用来复用连接的输入输出缓冲区
+*/
+#ifndef MUDUO_NET_BUFFERPOOL_H
+#define MUDUO_NET_BUFFERPOOL_H
+
+#include "../base/noncopyable.h"
+#include "../base/Mutex.h"
+#include "Buffer.h"
+
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Free list of Buffer storage.
+///
+/*
+连接销毁时把它的Buffer(连同底层的vector)还回来，下一个连接直接拿去用，
+所以连接的频繁建立和断开不会每次都为缓冲区调用malloc/free。
+容量超过maxCapacity的Buffer不缓存，避免个别大流量连接的内存一直占着。
+最后一个TcpConnectionPtr可能在任意线程释放，所以用锁保护；
+与FixedSizePool一样由shared_ptr管理，连接持有它，可以比EventLoop活得久
+*/
+class BufferPool : noncopyable
+{
+public:
+    explicit BufferPool(size_t maxFree = 1024, size_t maxCapacity = 64*1024);
+    ~BufferPool();
+
+    //取一个空的Buffer，没有缓存时新建一个
+    Buffer take();
+    //回收buf的存储，调用后buf只能析构
+    void recycle(Buffer&& buf);
+
+    size_t freeBuffers() const;
+
+private:
+    mutable MutexLock mutex_;
+    std::vector<Buffer> free_;  // @GuardedBy mutex_
+    const size_t maxFree_;
+    const size_t maxCapacity_;
+};
+
+}//net
+}//muduo
+#endif
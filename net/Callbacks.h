@@ -4,8 +4,12 @@
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <string>
+
 #include "../base/Timestamp.h"
 
+struct tcp_info;
+
 namespace muduo
 {
 namespace net{
@@ -22,6 +26,15 @@ typedef boost::function<void (const TcpConnectionPtr&,
                               Buffer* buf,
                               Timestamp)> MessageCallback;
 typedef boost::function<void (const TcpConnectionPtr&)> CloseCallback;
+//输出队列全部发送完毕时调用
+typedef boost::function<void (const TcpConnectionPtr&)> WriteCompleteCallback;
+//输出队列的长度向上越过高水位时调用，第二个参数是当前的长度
+typedef boost::function<void (const TcpConnectionPtr&, size_t)> HighWaterMarkCallback;
+//定时采样到的TCP_INFO
+typedef boost::function<void (const TcpConnectionPtr&,
+                              const struct tcp_info&)> TcpInfoCallback;
+//引用计数的只读消息，广播时多个连接共享同一份数据
+typedef boost::shared_ptr<const std::string> PayloadPtr;
 }
 }
 #endif 
\ No newline at end of file
@@ -7,8 +7,9 @@
 #include "../base/noncopyable.h"
 #include "../base/Timestamp.h"
 
-#include <functional>
-#include <memory>
+#include <utility>
+
+#include <boost/function.hpp>
 
 namespace muduo
 {
@@ -18,8 +19,9 @@ namespace net
 class EventLoop;
 class Channel : noncopyable{
 public:
-    typedef std::function<void()> EventCallback;
-    typedef std::function<void(Timestamp)> ReadEventCallback;
+    //boost::function能把boost::bind(&X::f, this)放在内部的缓冲区里，std::function放不下，要分配内存
+    typedef boost::function<void()> EventCallback;
+    typedef boost::function<void(Timestamp)> ReadEventCallback;
 
     Channel(EventLoop* loop,int fd);
     ~Channel();
@@ -40,8 +42,13 @@ public:
     int events() const { return events_; }
     int set_revents(int revt) { revents_ = revt; }
     bool isNoneEvent() const { return events_ == kNoneEvent; }
+    bool isWriting() const { return events_ & kWriteEvent; }
+    bool isReading() const { return events_ & kReadEvent; }
 
     void enableReading() { events_|=kReadEvent; update(); }
+    void disableReading() { events_ &= ~kReadEvent; update(); }
+    void enableWriting() { events_ |= kWriteEvent; update(); }
+    void disableWriting() { events_ &= ~kWriteEvent; update(); }
     void disableAll() { events_ = kNoneEvent; update(); }
     //for Poller
     int index() { return index_; }
@@ -0,0 +1,217 @@
+#include "ConnectionPool.h"
+
+#include "../base/Logging.h"
+#include "EventLoop.h"
+#include "TcpClient.h"
+
+#include <boost/bind.hpp>
+
+#include <stdio.h>  // snprintf
+
+using namespace muduo;
+using namespace muduo::net;
+
+ConnectionPool::ConnectionPool(EventLoop* loop,
+                               const InetAddress& serverAddr,
+                               const std::string& name,
+                               int numConnections)
+  : loop_(loop),
+    serverAddr_(serverAddr),
+    name_(name),
+    numConnections_(numConnections),
+    maxConnections_(numConnections),
+    maxInFlight_(1),
+    idleTimeout_(60.0),
+    checkInterval_(1.0),
+    started_(false),
+    nextMemberId_(1)
+{
+    assert(numConnections_ > 0);
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    //定时器回调绑定的是this
+    if (started_)
+    {
+        loop_->cancel(timer_);
+    }
+}
+
+void ConnectionPool::start()
+{
+    loop_->assertInLoopThread();
+    assert(!started_);
+    assert(maxConnections_ >= numConnections_);
+    started_ = true;
+    for (int i = 0; i < numConnections_; ++i)
+    {
+        addMember();
+    }
+    timer_ = loop_->runEvery(checkInterval_, boost::bind(&ConnectionPool::onTimer, this));
+}
+
+void ConnectionPool::addMember()
+{
+    const int id = nextMemberId_++;
+    char buf[32];
+    snprintf(buf, sizeof buf, "-%d", id);
+
+    Member& member = members_[id];
+    member.client.reset(new TcpClient(loop_, serverAddr_, name_ + buf));
+    member.inFlight = 0;
+    member.lastActive = Timestamp::now();
+    member.client->enableRetry();
+    member.client->setConnectionCallback(
+        boost::bind(&ConnectionPool::onConnection, this, id, _1));
+    member.client->setMessageCallback(messageCallback_);
+    member.client->connect();
+}
+
+void ConnectionPool::onConnection(int id, const TcpConnectionPtr& conn)
+{
+    loop_->assertInLoopThread();
+    MemberMap::iterator it = members_.find(id);
+    if (it != members_.end())
+    {
+        Member& member = it->second;
+        if (conn->connected())
+        {
+            member.conn = conn;
+        }
+        else
+        {
+            //断开时在途的请求不会再有响应，由用户在connectionCallback_中处理
+            member.conn.reset();
+            member.inFlight = 0;
+        }
+        member.lastActive = Timestamp::now();
+    }
+    if (connectionCallback_)
+    {
+        connectionCallback_(conn);
+    }
+}
+/*
+成员个数很少，线性扫描比维护一个按负载排序的结构更划算
+*/
+TcpConnectionPtr ConnectionPool::acquire()
+{
+    loop_->assertInLoopThread();
+    Member* best = NULL;
+    bool connecting = false;
+    for (MemberMap::iterator it = members_.begin(); it != members_.end(); ++it)
+    {
+        Member& member = it->second;
+        if (!member.conn)
+        {
+            connecting = true;
+            continue;
+        }
+        if (member.inFlight < maxInFlight_
+            && (best == NULL || member.inFlight < best->inFlight))
+        {
+            best = &member;
+        }
+    }
+    if (best == NULL)
+    {
+        //还有连接正在建立时不再多建
+        if (!connecting && static_cast<int>(members_.size()) < maxConnections_)
+        {
+            LOG_INFO << "ConnectionPool::acquire [" << name_
+                     << "] - all busy, adding connection #" << members_.size() + 1;
+            addMember();
+        }
+        return TcpConnectionPtr();
+    }
+    ++best->inFlight;
+    best->lastActive = Timestamp::now();
+    return best->conn;
+}
+
+void ConnectionPool::release(const TcpConnectionPtr& conn)
+{
+    loop_->assertInLoopThread();
+    MemberMap::iterator it = findMember(conn);
+    //连接断开时在途计数已经清零
+    if (it != members_.end() && it->second.inFlight > 0)
+    {
+        --it->second.inFlight;
+        it->second.lastActive = Timestamp::now();
+    }
+}
+
+ConnectionPool::MemberMap::iterator ConnectionPool::findMember(const TcpConnectionPtr& conn)
+{
+    MemberMap::iterator it = members_.begin();
+    while (it != members_.end() && it->second.conn != conn)
+    {
+        ++it;
+    }
+    return it;
+}
+/*
+先回收空闲超时的多余连接，再对剩下的空闲连接做健康检查。
+回收时先从members_中删除，迟到的连接回调找不到成员就会被忽略
+*/
+void ConnectionPool::onTimer()
+{
+    loop_->assertInLoopThread();
+    Timestamp now = Timestamp::now();
+    MemberMap::iterator it = members_.begin();
+    while (it != members_.end()
+           && static_cast<int>(members_.size()) > numConnections_)
+    {
+        Member& member = it->second;
+        if (member.inFlight == 0
+            && timeDifference(now, member.lastActive) > idleTimeout_)
+        {
+            LOG_INFO << "ConnectionPool::onTimer [" << name_
+                     << "] - reaping idle " << member.client->name();
+            boost::shared_ptr<TcpClient> client(member.client);
+            members_.erase(it++);
+            client->disconnect();
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (!healthCheckCallback_)
+    {
+        return;
+    }
+    for (it = members_.begin(); it != members_.end(); ++it)
+    {
+        Member& member = it->second;
+        if (member.conn && member.inFlight == 0 && !healthCheckCallback_(member.conn))
+        {
+            LOG_WARN << "ConnectionPool::onTimer [" << name_
+                     << "] - health check failed on " << member.conn->name();
+            member.conn->forceClose();
+        }
+    }
+}
+
+int ConnectionPool::numConnected() const
+{
+    int n = 0;
+    for (MemberMap::const_iterator it = members_.begin(); it != members_.end(); ++it)
+    {
+        if (it->second.conn)
+            ++n;
+    }
+    return n;
+}
+
+int ConnectionPool::numInFlight() const
+{
+    int n = 0;
+    for (MemberMap::const_iterator it = members_.begin(); it != members_.end(); ++it)
+    {
+        n += it->second.inFlight;
+    }
+    return n;
+}
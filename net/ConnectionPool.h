@@ -0,0 +1,111 @@
+/*
+到一个上游服务器的连接池，每个IO线程的EventLoop各有一个
+*/
+#ifndef MUDUO_NET_CONNECTIONPOOL_H
+#define MUDUO_NET_CONNECTIONPOOL_H
+
+#include "../base/noncopyable.h"
+#include "../base/Timestamp.h"
+#include "Callbacks.h"
+#include "InetAddress.h"
+#include "TimerId.h"
+
+#include <map>
+#include <string>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class TcpClient;
+
+///
+/// Warm connections to one upstream, owned by one EventLoop.
+///
+/*
+池里的连接都属于同一个loop，在这个loop上处理的请求借用它们时没有跨线程的runInLoop，也不需要加锁；
+所以除了构造函数，所有成员函数都必须在loop线程调用。
+平时保持numConnections个连接，全部达到在途请求上限时临时多建，最多maxConnections个，
+多出来的连接空闲超过idleTimeout秒后关闭。
+一个每interval秒触发的定时器负责健康检查和回收空闲连接。
+每个连接由一个开启了重连的TcpClient维护，断开后自动重连
+*/
+class ConnectionPool : noncopyable
+{
+public:
+    //返回false表示连接不健康，池会强制关闭它，随后由TcpClient重连
+    typedef boost::function<bool (const TcpConnectionPtr&)> HealthCheckCallback;
+
+    ConnectionPool(EventLoop* loop,
+                   const InetAddress& serverAddr,
+                   const std::string& name,
+                   int numConnections);
+    ~ConnectionPool();
+
+    //以下设置需要在start()之前进行
+    void setMaxConnections(int maxConnections) { maxConnections_ = maxConnections; }
+    //每个连接同时借出的次数上限，用于不支持pipeline的协议时设为1
+    void setMaxInFlight(int maxInFlight) { maxInFlight_ = maxInFlight; }
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+    //每interval秒对没有在途请求的连接调用一次cb
+    void setHealthCheckCallback(const HealthCheckCallback& cb, double interval)
+    { healthCheckCallback_ = cb; checkInterval_ = interval; }
+    void setConnectionCallback(const ConnectionCallback& cb)
+    { connectionCallback_ = cb; }
+    void setMessageCallback(const MessageCallback& cb)
+    { messageCallback_ = cb; }
+
+    //建立numConnections个连接并启动定时器
+    void start();
+
+    //借出在途请求最少的已连接连接，全部满载时返回空，并在未达上限时多建一个连接
+    TcpConnectionPtr acquire();
+    //请求完成后归还
+    void release(const TcpConnectionPtr& conn);
+
+    EventLoop* getLoop() const { return loop_; }
+    //已建立的连接数
+    int numConnected() const;
+    int numInFlight() const;
+
+private:
+    struct Member
+    {
+        boost::shared_ptr<TcpClient> client;
+        TcpConnectionPtr conn;  // 已连接时非空
+        int inFlight;
+        Timestamp lastActive;
+    };
+    //以成员id为键，回调按id查找，成员被回收后迟到的回调直接忽略
+    typedef std::map<int, Member> MemberMap;
+
+    void addMember();
+    void onConnection(int id, const TcpConnectionPtr& conn);
+    void onTimer();
+    MemberMap::iterator findMember(const TcpConnectionPtr& conn);
+
+    EventLoop* loop_;
+    const InetAddress serverAddr_;
+    const std::string name_;
+    const int numConnections_;
+    int maxConnections_;
+    int maxInFlight_;
+    double idleTimeout_;
+    double checkInterval_;
+    TimerId timer_;  // 空闲回收和健康检查共用
+    HealthCheckCallback healthCheckCallback_;
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+    bool started_;
+    int nextMemberId_;
+    MemberMap members_;
+};
+
+}//net
+}//muduo
+#endif
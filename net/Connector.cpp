@@ -0,0 +1,266 @@
+#include "Connector.h"
+
+#include "../base/Logging.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "SocketsOps.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int Connector::kInitRetryDelayMs;
+const int Connector::kMaxRetryDelayMs;
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
+  : loop_(loop),
+    serverAddr_(serverAddr),
+    connect_(false),
+    state_(kDisconnected),
+    initRetryDelayMs_(kInitRetryDelayMs),
+    maxRetryDelayMs_(kMaxRetryDelayMs),
+    retryDelayMs_(kInitRetryDelayMs),
+    retryGeneration_(0)
+{
+    LOG_DEBUG << "ctor[" << this << "]";
+}
+
+Connector::~Connector()
+{
+    LOG_DEBUG << "dtor[" << this << "]";
+    assert(!channel_);
+}
+
+void Connector::start()
+{
+    connect_ = true;
+    loop_->runInLoop(boost::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop()
+{
+    loop_->assertInLoopThread();
+    if (state_ != kDisconnected)
+    {
+        return;
+    }
+    //立即连接，之前安排的重试作废
+    cancelRetry();
+    if (connect_)
+    {
+        connect();
+    }
+    else
+    {
+        LOG_DEBUG << "do not connect";
+    }
+}
+
+void Connector::stop()
+{
+    connect_ = false;
+    loop_->queueInLoop(boost::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::stopInLoop()
+{
+    loop_->assertInLoopThread();
+    cancelRetry();
+    if (state_ == kConnecting)
+    {
+        setState(kDisconnected);
+        int sockfd = removeAndResetChannel();
+        retry(sockfd);
+    }
+}
+/*
+根据connect的errno决定下一步：正在连接的交给Channel等待可写，
+暂时性的错误重试，其余的错误直接放弃
+*/
+void Connector::connect()
+{
+    int sockfd = sockets::createNonblockingOrDie(serverAddr_.family());
+    int ret = sockets::connect(sockfd, serverAddr_.getSockAddr(), serverAddr_.getSockLen());
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch (savedErrno)
+    {
+        case 0:
+        case EINPROGRESS:
+        case EINTR:
+        case EISCONN:
+            connecting(sockfd);
+            break;
+
+        case EAGAIN:
+        case EADDRINUSE:
+        case EADDRNOTAVAIL:
+        case ECONNREFUSED:
+        case ENETUNREACH:
+            retry(sockfd);
+            break;
+
+        case EACCES:
+        case EPERM:
+        case EAFNOSUPPORT:
+        case EALREADY:
+        case EBADF:
+        case EFAULT:
+        case ENOTSOCK:
+            LOG_SYSERR << "connect error in Connector::startInLoop " << savedErrno;
+            sockets::close(sockfd);
+            break;
+
+        default:
+            LOG_SYSERR << "Unexpected error in Connector::startInLoop " << savedErrno;
+            sockets::close(sockfd);
+            break;
+    }
+}
+
+/*
+连接断开后重连：间隔回到初始值，但仍然先等一个初始间隔，
+避免对端刚关闭(比如正在重启)时立刻连上去
+*/
+void Connector::restart()
+{
+    loop_->assertInLoopThread();
+    setState(kDisconnected);
+    retryDelayMs_ = initRetryDelayMs_;
+    connect_ = true;
+    scheduleRetry();
+}
+
+void Connector::connecting(int sockfd)
+{
+    setState(kConnecting);
+    assert(!channel_);
+    channel_.reset(new Channel(loop_, sockfd));
+    channel_->setWriteCallback(
+        boost::bind(&Connector::handleWrite, this)); // FIXME: unsafe
+    channel_->setErrorCallback(
+        boost::bind(&Connector::handleError, this)); // FIXME: unsafe
+    channel_->enableWriting();
+}
+
+int Connector::removeAndResetChannel()
+{
+    channel_->disableAll();
+    loop_->removeChannel(get_pointer(channel_));
+    int sockfd = channel_->fd();
+    // Can't reset channel_ here, because we are inside Channel::handleEvent
+    loop_->queueInLoop(boost::bind(&Connector::resetChannel, this)); // FIXME: unsafe
+    return sockfd;
+}
+
+void Connector::resetChannel()
+{
+    channel_.reset();
+}
+/*
+sockfd可写只说明连接过程结束了，不代表成功，要用SO_ERROR再确认一次
+*/
+void Connector::handleWrite()
+{
+    LOG_TRACE << "Connector::handleWrite " << state_;
+
+    if (state_ == kConnecting)
+    {
+        int sockfd = removeAndResetChannel();
+        int err = sockets::getSocketError(sockfd);
+        if (err)
+        {
+            LOG_WARN << "Connector::handleWrite - SO_ERROR = "
+                     << err << " " << strerror(err);
+            retry(sockfd);
+        }
+        else if (sockets::isSelfConnect(sockfd))
+        {
+            LOG_WARN << "Connector::handleWrite - Self connect";
+            retry(sockfd);
+        }
+        else
+        {
+            setState(kConnected);
+            if (connect_ && newConnectionCallback_)
+            {
+                newConnectionCallback_(sockfd);
+            }
+            else
+            {
+                sockets::close(sockfd);
+            }
+        }
+    }
+    else
+    {
+        // what happened?
+        assert(state_ == kDisconnected);
+    }
+}
+
+void Connector::handleError()
+{
+    LOG_ERROR << "Connector::handleError state=" << state_;
+    if (state_ == kConnecting)
+    {
+        int sockfd = removeAndResetChannel();
+        int err = sockets::getSocketError(sockfd);
+        LOG_TRACE << "SO_ERROR = " << err << " " << strerror(err);
+        retry(sockfd);
+    }
+}
+/*
+关闭这次失败的sockfd，隔retryDelayMs_毫秒再用新的socket连接，间隔每次翻倍并有上限
+*/
+void Connector::retry(int sockfd)
+{
+    sockets::close(sockfd);
+    setState(kDisconnected);
+    if (connect_)
+    {
+        scheduleRetry();
+    }
+    else
+    {
+        LOG_DEBUG << "do not connect";
+    }
+}
+/*
+每次安排重试都换一个代号并取消上一个定时器，
+即使取消来不及(比如定时器和取消在同一轮里)，过期的回调也会因代号不符而忽略
+*/
+void Connector::scheduleRetry()
+{
+    cancelRetry();
+    LOG_INFO << "Connector::retry - Retry connecting to " << serverAddr_.toHostPort()
+             << " in " << retryDelayMs_ << " milliseconds. ";
+    retryTimer_ = loop_->runAfter(retryDelayMs_/1000.0,
+        boost::bind(&Connector::retryInLoop, shared_from_this(), retryGeneration_));
+    retryDelayMs_ = std::min(retryDelayMs_ * 2, maxRetryDelayMs_);
+}
+
+void Connector::cancelRetry()
+{
+    ++retryGeneration_;
+    loop_->cancel(retryTimer_);
+}
+
+void Connector::retryInLoop(uint64_t generation)
+{
+    loop_->assertInLoopThread();
+    if (generation != retryGeneration_ || state_ != kDisconnected || channel_)
+    {
+        LOG_DEBUG << "Connector::retryInLoop - stale retry ignored";
+        return;
+    }
+    if (connect_)
+    {
+        connect();
+    }
+}
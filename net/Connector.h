@@ -0,0 +1,96 @@
+/*
+Connector用于主动发起TCP连接，是Acceptor的对应物，由TcpClient使用。
+它只负责把socket连上，连接建立后通过回调把sockfd交给使用者
+*/
+#ifndef MUDUO_NET_CONNECTOR_H
+#define MUDUO_NET_CONNECTOR_H
+
+#include "../base/noncopyable.h"
+#include "InetAddress.h"
+#include "TimerId.h"
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class Channel;
+class EventLoop;
+
+///
+/// Non-blocking connector with capped exponential backoff.
+///
+/*
+非阻塞connect返回EINPROGRESS后，把sockfd的Channel设为关注可写事件，
+可写时再用SO_ERROR确认连接是否成功，并排除连上自己的情况。
+失败时按初始重试间隔重试，每次翻倍，直到maxRetryDelayMs为止。
+重试的回调持有Connector的shared_ptr，并带着安排它时的代号；
+start()/stop()/restart()会取消尚未到期的重试，到期的旧回调因代号不符而被忽略
+*/
+class Connector : noncopyable,
+                  public boost::enable_shared_from_this<Connector>
+{
+public:
+    typedef boost::function<void (int sockfd)> NewConnectionCallback;
+
+    Connector(EventLoop* loop, const InetAddress& serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallback(const NewConnectionCallback& cb)
+    { newConnectionCallback_ = cb; }
+    //重试间隔从initMs开始每次翻倍，最多maxMs，需要在start()之前设置
+    void setRetryDelay(int initMs, int maxMs)
+    { initRetryDelayMs_ = initMs; maxRetryDelayMs_ = maxMs; retryDelayMs_ = initMs; }
+
+    const InetAddress& serverAddress() const { return serverAddr_; }
+
+    void start();  // can be called in any thread
+    void restart();  // must be called in loop thread
+    void stop();  // can be called in any thread
+
+    static const int kInitRetryDelayMs = 500;
+    static const int kMaxRetryDelayMs = 30*1000;
+
+private:
+    enum States { kDisconnected, kConnecting, kConnected };
+
+    void setState(States s) { state_ = s; }
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int sockfd);
+    void handleWrite();
+    void handleError();
+    void retry(int sockfd);
+    //retryDelayMs_毫秒后再连接
+    void scheduleRetry();
+    //作废已安排的重试
+    void cancelRetry();
+    void retryInLoop(uint64_t generation);
+    //停止关注sockfd并返回它，Channel留到本轮事件处理结束后再销毁
+    int removeAndResetChannel();
+    void resetChannel();
+
+    EventLoop* loop_;
+    InetAddress serverAddr_;
+    bool connect_;  // FIXME: use atomic variable
+    States state_;  // FIXME: use atomic variable
+    boost::scoped_ptr<Channel> channel_;
+    NewConnectionCallback newConnectionCallback_;
+    int initRetryDelayMs_;
+    int maxRetryDelayMs_;
+    int retryDelayMs_;
+    TimerId retryTimer_;
+    uint64_t retryGeneration_;  // 每安排或取消一次重试加一
+};
+
+typedef boost::shared_ptr<Connector> ConnectorPtr;
+
+}//net
+}//muduo
+#endif
@@ -53,7 +53,9 @@ EventLoop::EventLoop()
     poller_(new Poller(this)),
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
-    wakeupChannel_(new Channel(this, wakeupFd_))
+    wakeupChannel_(new Channel(this, wakeupFd_)),
+    connectionPool_(new FixedSizePool),
+    bufferPool_(new BufferPool)
 {
     LOG_TRACE<<"EventLoop created" <<this<<"in thread"<<threadId_;
     if(t_loopInThisThread){
@@ -142,6 +144,9 @@ TimerId EventLoop::runEvery(double interval, const TimerCallback& cb){
     Timestamp time(addTime(Timestamp::now(), interval));
     return timerQueue_->addTimer(cb, time, interval);
 }
+void EventLoop::cancel(TimerId timerId){
+    timerQueue_->cancel(timerId);
+}
 void EventLoop::updateChannel(Channel* channel)
 {
   assert(channel->ownerLoop() == this);
@@ -149,6 +154,13 @@ void EventLoop::updateChannel(Channel* channel)
   poller_->updateChannel(channel);
 }
 
+void EventLoop::removeChannel(Channel* channel)
+{
+    assert(channel->ownerLoop() == this);
+    assertInLoopThread();
+    poller_->removeChannel(channel);
+}
+
 void EventLoop::abortNotInLoopThread()
 {
     LOG_FATAL << "EventLoop::abortNotInLoopThread - EventLoop " << this
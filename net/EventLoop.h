@@ -16,6 +16,9 @@
 #include "../base/Thread.h"
 #include "Callbacks.h"
 #include "TimerId.h"
+#include "BufferPool.h"
+#include "FixedSizePool.h"
+#include "TrafficCounters.h"
 #include <boost/scoped_ptr.hpp>
 namespace muduo{
 
@@ -55,9 +58,24 @@ public:
     /// Runs callback every @c interval seconds.
     ///
     TimerId runEvery(double interval, const TimerCallback& cb);
+    ///
+    /// Cancels the timer.
+    /// Safe to call from other threads.
+    ///
+    void cancel(TimerId timerId);
     
     void wakeup();
     void updateChannel(Channel* channel);
+    void removeChannel(Channel* channel);
+
+    ///
+    /// Traffic of all connections in this loop, safe to read from other threads.
+    ///
+    TrafficCounters* trafficCounters() { return &trafficCounters_; }
+    // 本loop上的TcpConnection从这里分配，连接断开后内存留着给下一个连接用
+    const boost::shared_ptr<FixedSizePool>& connectionPool() const { return connectionPool_; }
+    // 本loop上连接的输入输出缓冲区，连接销毁时还回来
+    const boost::shared_ptr<BufferPool>& bufferPool() const { return bufferPool_; }
 
     void assertInLoopThread(){
         if(!isInLoopThread()){
@@ -94,6 +112,10 @@ private:
     ChannelList activeChannels_;
     MutexLock mutex_;
     std::vector<Functor> pendingFunctors_; // @GuardedBy mutex_
+    TrafficCounters trafficCounters_;
+    // 分配出去的块可能在EventLoop析构之后才归还，所以共享所有权
+    const boost::shared_ptr<FixedSizePool> connectionPool_;
+    const boost::shared_ptr<BufferPool> bufferPool_;
 };
 
 }//net
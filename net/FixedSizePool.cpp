@@ -0,0 +1,71 @@
+#include "FixedSizePool.h"
+
+#include <new>
+
+using namespace muduo;
+using namespace muduo::net;
+
+FixedSizePool::FixedSizePool(size_t maxFree)
+  : blockSize_(0),
+    freeList_(NULL),
+    numFree_(0),
+    maxFree_(maxFree)
+{
+}
+
+FixedSizePool::~FixedSizePool()
+{
+    while (freeList_)
+    {
+        FreeNode* node = freeList_;
+        freeList_ = node->next;
+        ::operator delete(node);
+    }
+}
+
+void* FixedSizePool::allocate(size_t size)
+{
+    {
+        MutexLockGuard lock(mutex_);
+        if (blockSize_ == 0 && size >= sizeof(FreeNode))
+        {
+            blockSize_ = size;
+        }
+        if (size == blockSize_ && freeList_)
+        {
+            FreeNode* node = freeList_;
+            freeList_ = node->next;
+            --numFree_;
+            return node;
+        }
+    }
+    return ::operator new(size);
+}
+
+void FixedSizePool::deallocate(void* p, size_t size)
+{
+    {
+        MutexLockGuard lock(mutex_);
+        if (size == blockSize_ && numFree_ < maxFree_)
+        {
+            FreeNode* node = static_cast<FreeNode*>(p);
+            node->next = freeList_;
+            freeList_ = node;
+            ++numFree_;
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+size_t FixedSizePool::blockSize() const
+{
+    MutexLockGuard lock(mutex_);
+    return blockSize_;
+}
+
+size_t FixedSizePool::freeBlocks() const
+{
+    MutexLockGuard lock(mutex_);
+    return numFree_;
+}
@@ -0,0 +1,108 @@
+/*
+定长内存块的空闲链表，每个EventLoop一个，用来分配TcpConnection
+*/
+#ifndef MUDUO_NET_FIXEDSIZEPOOL_H
+#define MUDUO_NET_FIXEDSIZEPOOL_H
+
+#include "../base/noncopyable.h"
+#include "../base/Mutex.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <stddef.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Free list of equally sized blocks.
+///
+/*
+块的大小由第一次分配决定，之后同样大小的请求从空闲链表取，释放时挂回链表，
+大小不同的请求直接交给operator new/delete。
+连接通常在IO线程创建，但最后一个TcpConnectionPtr可能在任意线程释放，所以用锁保护链表，
+这把锁几乎不会有竞争。
+pool用shared_ptr管理，分配器持有它，所以比分出去的每一块都活得久：
+EventLoop析构时定时器和pendingFunctors_中的weak_ptr<TcpConnection>才释放控制块，
+weak_ptr也可能比EventLoop活得更久
+*/
+class FixedSizePool : noncopyable
+{
+public:
+    //链表中最多缓存maxFree块，多出的直接还给operator delete
+    explicit FixedSizePool(size_t maxFree = 1024);
+    ~FixedSizePool();
+
+    void* allocate(size_t size);
+    void deallocate(void* p, size_t size);
+
+    size_t blockSize() const;
+    size_t freeBlocks() const;
+
+private:
+    struct FreeNode
+    {
+        FreeNode* next;
+    };
+
+    mutable MutexLock mutex_;
+    size_t blockSize_;  // @GuardedBy mutex_
+    FreeNode* freeList_;  // @GuardedBy mutex_
+    size_t numFree_;  // @GuardedBy mutex_
+    const size_t maxFree_;
+};
+
+///
+/// Allocator adaptor for boost::allocate_shared.
+///
+/*
+allocate_shared会把分配器rebind到内部的控制块类型，
+所以对象和引用计数在同一块内存里，只向pool要一次。
+控制块里保存着分配器的拷贝，它持有的pool引用要到这块内存归还之后才释放
+*/
+template<typename T>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind
+    {
+        typedef PoolAllocator<U> other;
+    };
+
+    explicit PoolAllocator(const boost::shared_ptr<FixedSizePool>& pool) : pool_(pool) { }
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool_(other.pool()) { }
+
+    T* allocate(size_t n)
+    { return static_cast<T*>(pool_->allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n)
+    { pool_->deallocate(p, n * sizeof(T)); }
+
+    const boost::shared_ptr<FixedSizePool>& pool() const { return pool_; }
+
+private:
+    boost::shared_ptr<FixedSizePool> pool_;
+};
+
+template<typename T, typename U>
+inline bool operator==(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs)
+{ return lhs.pool() == rhs.pool(); }
+
+template<typename T, typename U>
+inline bool operator!=(const PoolAllocator<T>& lhs, const PoolAllocator<U>& rhs)
+{ return lhs.pool() != rhs.pool(); }
+
+}//net
+}//muduo
+#endif
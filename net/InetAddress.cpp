@@ -1,29 +1,144 @@
 #include "InetAddress.h"
 
 #include "SocketsOps.h"
+#include "../base/Logging.h"
 
+#include <stddef.h>  // offsetof
+#include <string.h>
 #include <strings.h>  // bzero
 #include <netinet/in.h>
 
+#include <algorithm>
+
 #include <boost/static_assert.hpp>
 using namespace muduo;
 using namespace muduo::net;
 
-BOOST_STATIC_ASSERT(sizeof(InetAddress) == sizeof(struct sockaddr_in));
+//三种地址的family字段位置相同，family()可以直接读addr_
+BOOST_STATIC_ASSERT(offsetof(sockaddr_in, sin_family) == offsetof(sockaddr_in6, sin6_family));
+BOOST_STATIC_ASSERT(offsetof(sockaddr_in, sin_family) == offsetof(sockaddr_un, sun_family));
 
 static const in_addr_t kInaddrAny = INADDR_ANY;
-InetAddress::InetAddress(uint16_t port){
-    bzero(&addr_, sizeof addr_);
-    addr_.sin_family = AF_INET;
-    addr_.sin_addr.s_addr = sockets::hostToNetwork32(kInaddrAny);
-    addr_.sin_port = sockets::hostToNetwork16(port);
+InetAddress::InetAddress(uint16_t port, bool ipv6){
+    if (ipv6)
+    {
+        bzero(&addr6_, sizeof addr6_);
+        addr6_.sin6_family = AF_INET6;
+        addr6_.sin6_addr = in6addr_any;
+        addr6_.sin6_port = sockets::hostToNetwork16(port);
+        len_ = sizeof addr6_;
+    }
+    else
+    {
+        bzero(&addr_, sizeof addr_);
+        addr_.sin_family = AF_INET;
+        addr_.sin_addr.s_addr = sockets::hostToNetwork32(kInaddrAny);
+        addr_.sin_port = sockets::hostToNetwork16(port);
+        len_ = sizeof addr_;
+    }
 }
+//含':'的按IPv6解析
 InetAddress::InetAddress(const std::string& ip, uint16_t port){
-    bzero(&addr_, sizeof addr_);
-    sockets::fromHostPort(ip.c_str(), port, &addr_);
+    if (ip.find(':') != std::string::npos)
+    {
+        bzero(&addr6_, sizeof addr6_);
+        sockets::fromHostPort(ip.c_str(), port, &addr6_);
+        len_ = sizeof addr6_;
+    }
+    else
+    {
+        bzero(&addr_, sizeof addr_);
+        sockets::fromHostPort(ip.c_str(), port, &addr_);
+        len_ = sizeof addr_;
+    }
+}
+
+InetAddress::InetAddress(const struct sockaddr_in& addr)
+  : addr_(addr),
+    len_(sizeof addr)
+{
+}
+
+InetAddress::InetAddress(const struct sockaddr_in6& addr)
+  : addr6_(addr),
+    len_(sizeof addr)
+{
 }
+
+InetAddress::InetAddress(const struct sockaddr_storage& addr, socklen_t len)
+{
+    bzero(&addrun_, sizeof addrun_);
+    len_ = std::min(len, static_cast<socklen_t>(sizeof addrun_));
+    memcpy(&addrun_, &addr, len_);
+}
+/*
+路径型地址的长度包括结尾的'\0'；抽象名字的sun_path[0]为'\0'，长度只算到名字结尾
+*/
+InetAddress InetAddress::unixAddress(const std::string& path)
+{
+    InetAddress addr;
+    bzero(&addr.addrun_, sizeof addr.addrun_);
+    addr.addrun_.sun_family = AF_UNIX;
+    const bool abstract = !path.empty() && path[0] == '@';
+    size_t len = abstract ? path.size() : path.size() + 1;
+    if (len > sizeof addr.addrun_.sun_path)
+    {
+        LOG_ERROR << "InetAddress::unixAddress - path too long: " << path;
+        len = sizeof addr.addrun_.sun_path;
+    }
+    memcpy(addr.addrun_.sun_path, path.data(), std::min(path.size(), len));
+    if (abstract)
+    {
+        addr.addrun_.sun_path[0] = '\0';
+    }
+    else
+    {
+        addr.addrun_.sun_path[len-1] = '\0';
+    }
+    addr.len_ = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + len);
+    return addr;
+}
+
+const struct sockaddr* InetAddress::getSockAddr() const
+{
+    return static_cast<const struct sockaddr*>(implicit_cast<const void*>(&addr6_));
+}
+
+void InetAddress::setSockAddrInet(const struct sockaddr_in& addr)
+{
+    addr_ = addr;
+    len_ = sizeof addr;
+}
+
 std::string InetAddress::toHostPort() const{
-     char buf[32];
-    sockets::toHostPort(buf, sizeof buf, addr_);
+    if (isUnix())
+    {
+        const size_t offset = offsetof(struct sockaddr_un, sun_path);
+        if (len_ <= offset)
+        {
+            return std::string();  // unnamed, e.g. the peer of an accepted socket
+        }
+        const size_t n = len_ - offset;
+        if (addrun_.sun_path[0] == '\0')
+        {
+            return "@" + std::string(addrun_.sun_path + 1, n - 1);
+        }
+        return std::string(addrun_.sun_path, strnlen(addrun_.sun_path, n));
+    }
+    char buf[64];
+    if (family() == AF_INET6)
+        sockets::toHostPort(buf, sizeof buf, addr6_);
+    else
+        sockets::toHostPort(buf, sizeof buf, addr_);
     return buf;
-}
\ No newline at end of file
+}
+
+std::string InetAddress::toIp() const
+{
+    char buf[INET6_ADDRSTRLEN] = "";
+    if (family() == AF_INET6)
+        ::inet_ntop(AF_INET6, &addr6_.sin6_addr, buf, sizeof buf);
+    else if (family() == AF_INET)
+        ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof buf);
+    return buf;
+}
@@ -1,5 +1,6 @@
 /*
-对struct sockaddr_in的封装
+对socket地址的封装，可以是IPv4(struct sockaddr_in)、IPv6(struct sockaddr_in6)
+或者Unix domain socket(struct sockaddr_un)
 */
 #ifndef MUDUO_NET_INETADDRESS_H
 #define MUDUO_NET_INETADDRESS_H
@@ -9,6 +10,8 @@
 #include <string>
 
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 namespace muduo
 {
@@ -19,27 +22,52 @@ class InetAddress : public copyable
 public:
 /*
 对于构造函数
-可以只传入端口号，那么addr_的ip将会是本机(INADDR_ANY)。也可以传入ip和端口号来进行设置
+可以只传入端口号，那么addr_的ip将会是本机(INADDR_ANY或in6addr_any)。也可以传入ip和端口号来进行设置
 */
     /// Constructs an endpoint with given port number.
     /// Mostly used in TcpServer listening.
-    explicit InetAddress(uint16_t port);
+    explicit InetAddress(uint16_t port, bool ipv6 = false);
 
     /// Constructs an endpoint with given ip and port.
-    /// @c ip should be "1.2.3.4"
+    /// @c ip should be "1.2.3.4" or "::1"
     InetAddress(const std::string& ip, uint16_t port);
     /// Constructs an endpoint with given struct @c sockaddr_in
     /// Mostly used when accepting new connections
-    InetAddress(const struct sockaddr_in& addr)
-        : addr_(addr)
-    { }
+    InetAddress(const struct sockaddr_in& addr);
+    InetAddress(const struct sockaddr_in6& addr);
+    /// Constructs from the result of accept()/getsockname()/getpeername()
+    InetAddress(const struct sockaddr_storage& addr, socklen_t len);
+
+    /// Unix domain socket address.
+    /// A @c path starting with '@' is in the Linux abstract namespace,
+    /// it leaves no file behind and needs no unlink().
+    static InetAddress unixAddress(const std::string& path);
+
+    sa_family_t family() const { return addr_.sin_family; }
+    bool isUnix() const { return family() == AF_UNIX; }
+    //"1.2.3.4:80"、"[::1]:80"，Unix domain socket为路径，抽象名字以'@'开头
     std::string toHostPort() const;
+    //只有地址部分，没有端口，Unix domain socket返回空串
+    std::string toIp() const;
+
     // default copy/assignment are Okay
+    const struct sockaddr* getSockAddr() const;
+    socklen_t getSockLen() const { return len_; }
+    // IPv4 only
     const struct sockaddr_in& getSockAddrInet() const { return addr_; }
-    void setSockAddrInet(const struct sockaddr_in& addr) { addr_ = addr; }
+    void setSockAddrInet(const struct sockaddr_in& addr);
 private:
-  struct sockaddr_in addr_;
+    InetAddress() { }
+
+    union
+    {
+        struct sockaddr_in addr_;
+        struct sockaddr_in6 addr6_;
+        struct sockaddr_un addrun_;
+    };
+    //bind/connect时传给内核的长度，抽象名字的长度不能从sun_path推算出来
+    socklen_t len_;
 };
 }//net
 }//muduo
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,61 @@
+#include "LengthHeaderCodec.h"
+
+#include "../base/Logging.h"
+#include "TcpConnection.h"
+
+#include <limits>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t LengthHeaderCodec::kHeaderLen;
+const size_t LengthHeaderCodec::kDefaultMaxFrameSize;
+
+LengthHeaderCodec::LengthHeaderCodec(const FrameCallback& cb, size_t maxFrameSize)
+  : frameCallback_(cb),
+    maxFrameSize_(std::min(maxFrameSize,
+                           static_cast<size_t>(std::numeric_limits<int>::max() - kHeaderLen)))
+{
+}
+/*
+一次可能收到多个帧，也可能只收到半个帧：循环处理完所有完整的帧，剩下的留在buf里等下次
+*/
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr& conn,
+                                  Buffer* buf,
+                                  Timestamp receiveTime)
+{
+    while (buf->readableBytes() >= kHeaderLen)
+    {
+        const uint32_t len = static_cast<uint32_t>(buf->peekInt32());
+        if (len > maxFrameSize_)
+        {
+            LOG_ERROR << "LengthHeaderCodec::onMessage [" << conn->name()
+                      << "] - invalid length " << len;
+            buf->retrieveAll();
+            conn->forceClose();
+            break;
+        }
+        if (buf->readableBytes() < kHeaderLen + len)
+        {
+            break;
+        }
+        StringPiece frame(buf->peek() + kHeaderLen, static_cast<int>(len));
+        frameCallback_(conn, frame, receiveTime);
+        buf->retrieve(kHeaderLen + len);
+    }
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, Buffer* buf)
+{
+    const size_t len = buf->readableBytes();
+    assert(len <= maxFrameSize_);
+    buf->prependInt32(static_cast<int32_t>(len));
+    conn->send(buf);
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, const StringPiece& message)
+{
+    Buffer buf;
+    buf.append(message.data(), message.size());
+    send(conn, &buf);
+}
@@ -0,0 +1,60 @@
+/*
+以4字节长度为头部的分帧编解码器
+*/
+#ifndef MUDUO_NET_LENGTHHEADERCODEC_H
+#define MUDUO_NET_LENGTHHEADERCODEC_H
+
+#include "../base/noncopyable.h"
+#include "../base/StringPiece.h"
+#include "../base/Timestamp.h"
+#include "Buffer.h"
+#include "Callbacks.h"
+
+#include <stdint.h>
+
+#include <boost/function.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Frames are a 4-byte big-endian payload length followed by the payload.
+///
+/*
+用法：把onMessage设为TcpConnection/TcpServer的MessageCallback，
+每收到一个完整的帧调用一次FrameCallback。frame直接指向inputBuffer中的数据，不拷贝，
+只在回调期间有效，需要保留的话由用户自己拷贝。
+长度超过maxFrameSize的帧视为攻击或者协议错误，直接关闭连接，不会为它分配内存。
+发送时头部写进Buffer的kCheapPrepend预留区，payload不移动
+*/
+class LengthHeaderCodec : noncopyable
+{
+public:
+    typedef boost::function<void (const TcpConnectionPtr&,
+                                  const StringPiece& frame,
+                                  Timestamp)> FrameCallback;
+
+    static const size_t kHeaderLen = sizeof(int32_t);
+    static const size_t kDefaultMaxFrameSize = 64*1024*1024;
+
+    explicit LengthHeaderCodec(const FrameCallback& cb,
+                               size_t maxFrameSize = kDefaultMaxFrameSize);
+
+    size_t maxFrameSize() const { return maxFrameSize_; }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+
+    // buf中的全部数据作为一帧发送，头部就地写在buf的预留区里，发送后buf为空
+    void send(const TcpConnectionPtr& conn, Buffer* buf);
+    void send(const TcpConnectionPtr& conn, const StringPiece& message);
+
+private:
+    FrameCallback frameCallback_;
+    const size_t maxFrameSize_;
+};
+
+}//net
+}//muduo
+#endif
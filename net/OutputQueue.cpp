@@ -0,0 +1,355 @@
+#include "OutputQueue.h"
+
+#include "BufferPool.h"
+#include "SocketsOps.h"
+#include "../base/Logging.h"
+
+#include <errno.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <boost/make_shared.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+//一次writev最多携带的段数
+const int kMaxIovec = 16;
+}
+
+OutputQueue::FileRegion::~FileRegion()
+{
+    sockets::close(fd);
+}
+
+const char* OutputQueue::Segment::data() const
+{
+    assert(!isFile());
+    return payload ? payload->data() + offset : buffer->peek();
+}
+
+size_t OutputQueue::Segment::size() const
+{
+    if (isFile())
+        return fileRemaining;
+    return payload ? payload->size() - offset : buffer->readableBytes();
+}
+
+OutputQueue::OutputQueue(BufferPool* pool)
+  : pool_(pool),
+    readableBytes_(0),
+    zeroCopyThreshold_(0),
+    nextZeroCopySeq_(0)
+{
+}
+/*
+还被zerocopy发送引用的Buffer不是unique的，不回收
+*/
+OutputQueue::~OutputQueue()
+{
+    if (pool_ == NULL)
+        return;
+    if (spare_)
+    {
+        pool_->recycle(std::move(*spare_));
+    }
+    for (SegmentList::iterator it = segments_.begin(); it != segments_.end(); ++it)
+    {
+        if (it->buffer && it->buffer.unique())
+        {
+            pool_->recycle(std::move(*it->buffer));
+        }
+    }
+}
+
+void OutputQueue::append(const char* data, size_t len)
+{
+    if (len == 0)
+        return;
+    //队尾是拷贝段就直接追加，否则新开一段
+    if (segments_.empty() || !segments_.back().buffer || segments_.back().sealed)
+    {
+        pushBufferSegment();
+    }
+    segments_.back().buffer->append(data, len);
+    readableBytes_ += len;
+}
+/*
+队尾是可追加的拷贝段时直接拷贝过去，省得多出一段；
+否则新开一段并与buf交换底层的vector，一个字节也不拷贝
+*/
+void OutputQueue::append(Buffer* buf)
+{
+    const size_t len = buf->readableBytes();
+    if (len == 0)
+        return;
+    if (!segments_.empty() && segments_.back().buffer && !segments_.back().sealed)
+    {
+        segments_.back().buffer->append(buf->peek(), len);
+        buf->retrieveAll();
+    }
+    else
+    {
+        pushBufferSegment();
+        segments_.back().buffer->swap(*buf);
+    }
+    readableBytes_ += len;
+}
+
+void OutputQueue::pushBufferSegment()
+{
+    Segment seg;
+    seg.offset = 0;
+    seg.fileOffset = 0;
+    seg.fileRemaining = 0;
+    seg.sealed = false;
+    if (spare_)
+    {
+        seg.buffer.swap(spare_);
+    }
+    else if (pool_)
+    {
+        seg.buffer = boost::make_shared<Buffer>(pool_->take());
+    }
+    else
+    {
+        seg.buffer.reset(new Buffer);
+    }
+    segments_.push_back(seg);
+}
+
+void OutputQueue::append(const PayloadPtr& payload, size_t offset)
+{
+    assert(offset <= payload->size());
+    if (offset == payload->size())
+        return;
+    Segment seg;
+    seg.payload = payload;
+    seg.offset = offset;
+    seg.fileOffset = 0;
+    seg.fileRemaining = 0;
+    seg.sealed = false;
+    segments_.push_back(seg);
+    readableBytes_ += payload->size() - offset;
+}
+
+void OutputQueue::appendFile(int fd, off_t offset, size_t len)
+{
+    Segment seg;
+    seg.file.reset(new FileRegion(fd));
+    seg.offset = 0;
+    seg.fileOffset = offset;
+    seg.fileRemaining = len;
+    seg.sealed = false;
+    if (len == 0)
+        return;
+    segments_.push_back(seg);
+    readableBytes_ += len;
+}
+
+void OutputQueue::retrieve(size_t len)
+{
+    assert(len <= readableBytes_);
+    readableBytes_ -= len;
+    while (len > 0)
+    {
+        Segment& seg = segments_.front();
+        size_t n = seg.size();
+        if (len < n)
+        {
+            if (seg.isFile())
+            {
+                seg.fileOffset += len;
+                seg.fileRemaining -= len;
+            }
+            else if (seg.payload)
+                seg.offset += len;
+            else
+                seg.buffer->retrieve(len);
+            break;
+        }
+        len -= n;
+        popFront();
+    }
+}
+
+void OutputQueue::retrieveAll()
+{
+    while (!segments_.empty())
+    {
+        popFront();
+    }
+    readableBytes_ = 0;
+}
+
+void OutputQueue::popFront()
+{
+    Segment& seg = segments_.front();
+    //还被zerocopy发送引用的buffer不能复用
+    if (seg.buffer && seg.buffer.unique() && !spare_)
+    {
+        seg.buffer->retrieveAll();
+        spare_.swap(seg.buffer);
+    }
+    segments_.pop_front();
+}
+
+int OutputQueue::fillIovec(struct iovec* vec, int maxvec) const
+{
+    int cnt = 0;
+    for (SegmentList::const_iterator it = segments_.begin();
+         it != segments_.end() && !it->isFile() && cnt < maxvec; ++it)
+    {
+        vec[cnt].iov_base = const_cast<char*>(it->data());
+        vec[cnt].iov_len = it->size();
+        ++cnt;
+    }
+    return cnt;
+}
+/*
+与Buffer::readFd对应，只有一段时退化成一次普通的write
+*/
+ssize_t OutputQueue::writeFd(int fd, int* savedErrno)
+{
+    if (!segments_.empty() && segments_.front().isFile())
+    {
+        return sendFileFront(fd, savedErrno);
+    }
+    struct iovec vec[kMaxIovec];
+    const int iovcnt = fillIovec(vec, kMaxIovec);
+    if (zeroCopyThreshold_ > 0)
+    {
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; ++i)
+        {
+            total += vec[i].iov_len;
+        }
+        if (total >= zeroCopyThreshold_)
+        {
+            return sendZeroCopy(fd, vec, iovcnt, savedErrno);
+        }
+    }
+    const ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *savedErrno = errno;
+    }
+    else
+    {
+        retrieve(n);
+    }
+    return n;
+}
+/*
+sendfile()会更新传入的offset，所以用拷贝的值调用，再用retrieve统一推进
+*/
+ssize_t OutputQueue::sendFileFront(int fd, int* savedErrno)
+{
+    const Segment& seg = segments_.front();
+    off_t offset = seg.fileOffset;
+    const ssize_t n = ::sendfile(fd, seg.file->fd, &offset, seg.fileRemaining);
+    if (n < 0)
+    {
+        *savedErrno = errno;
+    }
+    else if (n == 0)
+    {
+        //文件比声明的区间短，丢弃剩余部分，否则会一直可写却写不出数据
+        LOG_ERROR << "OutputQueue::sendFileFront - file fd " << seg.file->fd
+                  << " ends before " << seg.fileRemaining << " more bytes";
+        retrieve(seg.fileRemaining);
+    }
+    else
+    {
+        retrieve(n);
+    }
+    return n;
+}
+/*
+与writev不同，sendmsg返回后内核仍然引用着这些内存，
+所以把涉及的段都复制一份(只是增加引用计数)保存下来，buffer段标记为sealed，不再追加数据以免vector重新分配。
+只有成功发送了数据的调用才会消耗内核的一个序号
+*/
+ssize_t OutputQueue::sendZeroCopy(int fd, const struct iovec* vec, int iovcnt, int* savedErrno)
+{
+    struct msghdr msg;
+    memZero(&msg, sizeof msg);
+    msg.msg_iov = const_cast<struct iovec*>(vec);
+    msg.msg_iovlen = iovcnt;
+    const ssize_t n = ::sendmsg(fd, &msg, MSG_ZEROCOPY | MSG_NOSIGNAL);
+    if (n < 0)
+    {
+        *savedErrno = errno;
+        return n;
+    }
+    if (n > 0)
+    {
+        ZeroCopyHold hold;
+        hold.seq = nextZeroCopySeq_++;
+        hold.segments.reserve(iovcnt);
+        for (int i = 0; i < iovcnt; ++i)
+        {
+            segments_[i].sealed = true;
+            hold.segments.push_back(segments_[i]);
+        }
+        zeroCopyHolds_.push_back(hold);
+    }
+    retrieve(n);
+    return n;
+}
+
+int OutputQueue::handleZeroCopyCompletions(int fd)
+{
+    int count = 0;
+    char control[128];
+    while (true)
+    {
+        struct msghdr msg;
+        memZero(&msg, sizeof msg);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+        //错误队列为空时返回EAGAIN
+        if (::recvmsg(fd, &msg, MSG_ERRQUEUE) < 0)
+        {
+            break;
+        }
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                && !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+            {
+                continue;
+            }
+            const struct sock_extended_err* serr =
+                reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cm));
+            if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+                continue;
+            }
+            //通知的是一段序号[ee_info, ee_data]
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                LOG_TRACE << "OutputQueue::handleZeroCopyCompletions - kernel copied "
+                          << serr->ee_info << "-" << serr->ee_data;
+            }
+            releaseZeroCopy(serr->ee_data);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void OutputQueue::releaseZeroCopy(uint32_t seq)
+{
+    //序号是32位回绕计数，用差值比较
+    while (!zeroCopyHolds_.empty()
+           && static_cast<int32_t>(zeroCopyHolds_.front().seq - seq) <= 0)
+    {
+        zeroCopyHolds_.pop_front();
+    }
+}
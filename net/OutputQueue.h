@@ -0,0 +1,128 @@
+/*
+TcpConnection的待发送队列
+*/
+#ifndef MUDUO_NET_OUTPUTQUEUE_H
+#define MUDUO_NET_OUTPUTQUEUE_H
+
+#include "../base/noncopyable.h"
+#include "Buffer.h"
+#include "Callbacks.h"
+
+#include <vector>
+
+#include <sys/types.h>
+
+#include <boost/container/deque.hpp>
+#include <boost/shared_ptr.hpp>
+
+struct iovec;
+
+namespace muduo
+{
+namespace net
+{
+
+class BufferPool;
+
+///
+/// Internal class for pending output of TcpConnection.
+///
+/*
+队列由若干段(Segment)组成，按send()的先后顺序排列：
+一段要么是拷贝进来的数据(保存在Buffer中)，要么是对共享只读数据PayloadPtr的引用，
+要么是文件中的一个区间。
+引用段只增加引用计数，不拷贝数据，所以同一条消息广播给多个连接时没有memcpy；
+文件段用sendfile()发送，数据不经过用户空间。
+开启MSG_ZEROCOPY后，大块的写直接引用队列中的内存，相关的段要保留到内核通知发送完成为止。
+两个队列用boost::container::deque，它在第一次插入时才分配内存，
+而std::deque在构造时就要分配，每个连接哪怕从来没有积压过数据也要付出这几次malloc
+*/
+class OutputQueue : noncopyable
+{
+public:
+    //拷贝段的Buffer从pool中取，析构时还回去；pool为NULL时直接new
+    explicit OutputQueue(BufferPool* pool = NULL);
+    ~OutputQueue();
+
+    //拷贝len字节到队尾
+    void append(const char* data, size_t len);
+    //引用payload中从offset开始的数据，不拷贝
+    void append(const PayloadPtr& payload, size_t offset);
+    //取走buf中的全部数据，能交换就不拷贝，buf随后为空
+    void append(Buffer* buf);
+    //文件fd中[offset, offset+len)的区间，fd由OutputQueue负责关闭
+    void appendFile(int fd, off_t offset, size_t len);
+
+    //队列中待发送的总字节数
+    size_t readableBytes() const { return readableBytes_; }
+    bool empty() const { return readableBytes_ == 0; }
+
+    //丢弃队首的len字节
+    void retrieve(size_t len);
+    void retrieveAll();
+
+    //把队首的若干段写到fd：内存段用writev，文件段用sendfile，返回值同::writev
+    ssize_t writeFd(int fd, int* savedErrno);
+
+    //一次写出不少于threshold字节时使用MSG_ZEROCOPY，0表示不使用
+    void setZeroCopyThreshold(size_t threshold) { zeroCopyThreshold_ = threshold; }
+    //读取fd错误队列中的MSG_ZEROCOPY完成通知，释放已完成的段，返回处理的通知个数
+    int handleZeroCopyCompletions(int fd);
+    //还在等待内核完成通知的zerocopy发送次数
+    size_t zeroCopyPending() const { return zeroCopyHolds_.size(); }
+
+private:
+    //持有文件描述符，最后一个引用释放时关闭
+    struct FileRegion : noncopyable
+    {
+        explicit FileRegion(int fdArg) : fd(fdArg) { }
+        ~FileRegion();
+        const int fd;
+    };
+
+    struct Segment
+    {
+        PayloadPtr payload;                 // 非空时为引用段
+        boost::shared_ptr<FileRegion> file; // 非空时为文件段
+        boost::shared_ptr<Buffer> buffer;   // 否则数据在buffer中
+        size_t offset;                      // payload中已发送的字节
+        off_t fileOffset;                   // 文件段下一次sendfile的位置
+        size_t fileRemaining;               // 文件段剩余的字节
+        bool sealed;                        // 内核可能还在引用buffer，不能再往里追加
+
+        bool isFile() const { return static_cast<bool>(file); }
+        const char* data() const;
+        size_t size() const;
+    };
+
+    typedef boost::container::deque<Segment> SegmentList;
+
+    //一次MSG_ZEROCOPY发送引用的段，seq是内核为这次发送分配的序号
+    struct ZeroCopyHold
+    {
+        uint32_t seq;
+        std::vector<Segment> segments;
+    };
+
+    //把队首连续的内存段填入vec，遇到文件段为止，最多maxvec个，返回填入的个数
+    int fillIovec(struct iovec* vec, int maxvec) const;
+    void popFront();
+    void pushBufferSegment();
+    ssize_t sendFileFront(int fd, int* savedErrno);
+    ssize_t sendZeroCopy(int fd, const struct iovec* vec, int iovcnt, int* savedErrno);
+    //释放序号不大于seq的所有zerocopy发送
+    void releaseZeroCopy(uint32_t seq);
+
+    BufferPool* const pool_;
+    SegmentList segments_;
+    //已发送完的Buffer留着复用，避免反复分配
+    boost::shared_ptr<Buffer> spare_;
+    size_t readableBytes_;
+    size_t zeroCopyThreshold_;
+    uint32_t nextZeroCopySeq_;
+    boost::container::deque<ZeroCopyHold> zeroCopyHolds_;
+};
+
+}//net
+}//muduo
+#endif
@@ -3,6 +3,7 @@
 #include "Channel.h"
 
 #include "../base/Logging.h"
+#include <algorithm>
 #include<poll.h>
 using namespace muduo;
 using namespace muduo::net;
@@ -75,12 +76,45 @@ void Poller::updateChannel(Channel* channel)
         int idx = channel->index();
         assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
         struct pollfd& pfd = pollfds_[idx];
-        assert(pfd.fd == channel->fd() || pfd.fd == -1);
+        assert(pfd.fd == channel->fd() || pfd.fd == -channel->fd()-1);
+        //之前被忽略的channel重新关注事件(比如startRead())时要恢复成原来的fd
+        pfd.fd = channel->fd();
         pfd.events = static_cast<short>(channel->events());
         pfd.revents = 0;
         if (channel->isNoneEvent()) {
             // ignore this pollfd
-            pfd.fd = -1;
+            //poll会忽略负的fd，用-fd-1而不是-1，removeChannel时还能找回原来的fd
+            pfd.fd = -channel->fd()-1;
+        }
+    }
+}
+/*
+把要删除的pollfd与数组末尾的交换后pop_back，复杂度O(1)
+*/
+void Poller::removeChannel(Channel* channel)
+{
+    assertInLoopThread();
+    LOG_TRACE << "fd = " << channel->fd();
+    assert(channels_.find(channel->fd()) != channels_.end());
+    assert(channels_[channel->fd()] == channel);
+    assert(channel->isNoneEvent());
+    int idx = channel->index();
+    assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
+    const struct pollfd& pfd = pollfds_[idx]; (void)pfd;
+    assert(pfd.fd == -channel->fd()-1 && pfd.events == channel->events());
+    size_t n = channels_.erase(channel->fd());
+    assert(n == 1); (void)n;
+    if (implicit_cast<size_t>(idx) == pollfds_.size()-1) {
+        pollfds_.pop_back();
+    } else {
+        int channelAtEnd = pollfds_.back().fd;
+        iter_swap(pollfds_.begin()+idx, pollfds_.end()-1);
+        if (channelAtEnd < 0) {
+            channelAtEnd = -channelAtEnd-1;
         }
+        channels_[channelAtEnd]->set_index(idx);
+        pollfds_.pop_back();
     }
+    //之后还可以重新加入
+    channel->set_index(-1);
 }
\ No newline at end of file
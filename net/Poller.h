@@ -29,6 +29,9 @@ public:
     /// Changes the interested I/O events.
     /// Must be called in the loop thread.
     void updateChannel(Channel* channel);
+    /// Remove the channel, when it destructs.
+    /// Must be called in the loop thread.
+    void removeChannel(Channel* channel);
 
     void assertInLoopThread() { ownerLoop_->assertInLoopThread();}
 private:
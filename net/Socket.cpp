@@ -2,10 +2,14 @@
 
 #include "InetAddress.h"
 #include "SocketsOps.h"
+#include "../base/Logging.h"
 
+#include <linux/sockios.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <stdio.h>  // snprintf
 #include <strings.h>  // bzero
+#include <sys/ioctl.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -13,9 +17,51 @@ Socket::~Socket()
 {
     sockets::close(sockfd_);
 }
+bool Socket::getTcpInfo(struct tcp_info* tcpi) const
+{
+    socklen_t len = sizeof(*tcpi);
+    bzero(tcpi, len);
+    return ::getsockopt(sockfd_, SOL_TCP, TCP_INFO, tcpi, &len) == 0;
+}
+
+bool Socket::getTcpInfoString(char* buf, int len) const
+{
+    struct tcp_info tcpi;
+    bool ok = getTcpInfo(&tcpi);
+    if (ok)
+    {
+        //rtt和rttvar的单位是微秒
+        snprintf(buf, len, "rtt=%u rttvar=%u cwnd=%u ssthresh=%u "
+                 "retransmits=%u total_retrans=%u unacked=%u lost=%u "
+                 "rto=%u snd_mss=%u sendq=%d",
+                 tcpi.tcpi_rtt,
+                 tcpi.tcpi_rttvar,
+                 tcpi.tcpi_snd_cwnd,
+                 tcpi.tcpi_snd_ssthresh,
+                 tcpi.tcpi_retransmits,
+                 tcpi.tcpi_total_retrans,
+                 tcpi.tcpi_unacked,
+                 tcpi.tcpi_lost,
+                 tcpi.tcpi_rto,
+                 tcpi.tcpi_snd_mss,
+                 getSendQueueBytes());
+    }
+    return ok;
+}
+
+int Socket::getSendQueueBytes() const
+{
+    int bytes = 0;
+    if (::ioctl(sockfd_, SIOCOUTQ, &bytes) < 0)
+    {
+        return -1;
+    }
+    return bytes;
+}
+
 void Socket::bindAddress(const InetAddress& addr)
 {
-    sockets::bindOrDie(sockfd_, addr.getSockAddrInet());
+    sockets::bindOrDie(sockfd_, addr.getSockAddr(), addr.getSockLen());
 }
 
 void Socket::listen()
@@ -25,12 +71,13 @@ void Socket::listen()
 
 int Socket::accept(InetAddress* peeraddr)
 {
-    struct sockaddr_in addr;
+    struct sockaddr_storage addr;
     bzero(&addr, sizeof addr);
-    int connfd = sockets::accept(sockfd_, &addr);
+    socklen_t addrlen = 0;
+    int connfd = sockets::accept(sockfd_, &addr, &addrlen);
     if (connfd >= 0)
     {
-        peeraddr->setSockAddrInet(addr);
+        *peeraddr = InetAddress(addr, addrlen);
     }
     return connfd;
 }
@@ -41,4 +88,162 @@ void Socket::setReuseAddr(bool on)
     ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR,
                &optval, sizeof optval);
     // FIXME CHECK
+}
+void Socket::shutdownWrite()
+{
+    sockets::shutdownWrite(sockfd_);
+}
+
+void Socket::setLinger(bool on, int seconds)
+{
+    struct linger ling;
+    ling.l_onoff = on ? 1 : 0;
+    ling.l_linger = seconds;
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_LINGER,
+                     &ling, sizeof ling) < 0)
+    {
+        LOG_SYSERR << "SO_LINGER failed.";
+    }
+}
+
+bool Socket::setZeroCopy(bool on)
+{
+    int optval = on ? 1 : 0;
+    return ::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY,
+                        &optval, sizeof optval) == 0;
+}
+
+void Socket::setReusePort(bool on)
+{
+#ifdef SO_REUSEPORT
+    int optval = on ? 1 : 0;
+    int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT,
+                           &optval, sizeof optval);
+    if (ret < 0 && on)
+    {
+        LOG_SYSERR << "SO_REUSEPORT failed.";
+    }
+#else
+    if (on)
+    {
+        LOG_ERROR << "SO_REUSEPORT is not supported.";
+    }
+#endif
+}
+
+void Socket::setTcpNoDelay(bool on)
+{
+    int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_NODELAY,
+                     &optval, sizeof optval) < 0)
+    {
+        LOG_SYSERR << "TCP_NODELAY failed.";
+    }
+}
+
+void Socket::setKeepAlive(bool on)
+{
+    int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE,
+                     &optval, sizeof optval) < 0)
+    {
+        LOG_SYSERR << "SO_KEEPALIVE failed.";
+    }
+}
+
+void Socket::setKeepAliveParams(int idle, int interval, int count)
+{
+    if (idle > 0 && ::setsockopt(sockfd_, IPPROTO_TCP, TCP_KEEPIDLE,
+                                 &idle, sizeof idle) < 0)
+    {
+        LOG_SYSERR << "TCP_KEEPIDLE failed.";
+    }
+    if (interval > 0 && ::setsockopt(sockfd_, IPPROTO_TCP, TCP_KEEPINTVL,
+                                     &interval, sizeof interval) < 0)
+    {
+        LOG_SYSERR << "TCP_KEEPINTVL failed.";
+    }
+    if (count > 0 && ::setsockopt(sockfd_, IPPROTO_TCP, TCP_KEEPCNT,
+                                  &count, sizeof count) < 0)
+    {
+        LOG_SYSERR << "TCP_KEEPCNT failed.";
+    }
+}
+
+void Socket::setSendBufferSize(int bytes)
+{
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF,
+                     &bytes, sizeof bytes) < 0)
+    {
+        LOG_SYSERR << "SO_SNDBUF failed.";
+    }
+}
+
+void Socket::setRecvBufferSize(int bytes)
+{
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF,
+                     &bytes, sizeof bytes) < 0)
+    {
+        LOG_SYSERR << "SO_RCVBUF failed.";
+    }
+}
+
+void Socket::setQuickAck(bool on)
+{
+    int optval = on ? 1 : 0;
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_QUICKACK,
+                     &optval, sizeof optval) < 0)
+    {
+        LOG_SYSERR << "TCP_QUICKACK failed.";
+    }
+}
+
+void Socket::setDeferAccept(int seconds)
+{
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                     &seconds, sizeof seconds) < 0)
+    {
+        LOG_SYSERR << "TCP_DEFER_ACCEPT failed.";
+    }
+}
+
+void Socket::setFastOpen(int queueLength)
+{
+    if (::setsockopt(sockfd_, IPPROTO_TCP, TCP_FASTOPEN,
+                     &queueLength, sizeof queueLength) < 0)
+    {
+        LOG_SYSERR << "TCP_FASTOPEN failed.";
+    }
+}
+
+void Socket::setBusyPoll(int usec)
+{
+#ifdef SO_BUSY_POLL
+    if (::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL,
+                     &usec, sizeof usec) < 0)
+    {
+        LOG_SYSERR << "SO_BUSY_POLL failed.";
+    }
+#else
+    LOG_ERROR << "SO_BUSY_POLL is not supported.";
+#endif
+}
+
+void Socket::applyOptions(const SocketOptions& options)
+{
+    if (options.tcpNoDelay)
+        setTcpNoDelay(true);
+    if (options.keepAlive)
+    {
+        setKeepAlive(true);
+        setKeepAliveParams(options.keepIdle, options.keepInterval, options.keepCount);
+    }
+    if (options.sendBufferSize > 0)
+        setSendBufferSize(options.sendBufferSize);
+    if (options.recvBufferSize > 0)
+        setRecvBufferSize(options.recvBufferSize);
+    if (options.quickAck)
+        setQuickAck(true);
+    if (options.busyPollUsec >= 0)
+        setBusyPoll(options.busyPollUsec);
 }
\ No newline at end of file
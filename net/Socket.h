@@ -5,12 +5,45 @@ Socket类是对文件描述符的封装，它的成员函数依然多是对Socke
 #define MUDUO_NET_SOCKET_H
 
 #include "../base/noncopyable.h"
+
+// struct tcp_info is in <netinet/tcp.h>
+struct tcp_info;
+
 namespace muduo
 {
 namespace net
 {
 class InetAddress;
 
+///
+/// Per-connection socket options, TcpServer applies them to every accepted socket.
+///
+//小于0的值表示保持系统默认
+struct SocketOptions
+{
+    SocketOptions()
+      : tcpNoDelay(false),
+        keepAlive(false),
+        keepIdle(-1),
+        keepInterval(-1),
+        keepCount(-1),
+        sendBufferSize(-1),
+        recvBufferSize(-1),
+        quickAck(false),
+        busyPollUsec(-1)
+    { }
+
+    bool tcpNoDelay;
+    bool keepAlive;
+    int keepIdle;        // seconds
+    int keepInterval;    // seconds
+    int keepCount;
+    int sendBufferSize;  // SO_SNDBUF
+    int recvBufferSize;  // SO_RCVBUF
+    bool quickAck;
+    int busyPollUsec;    // SO_BUSY_POLL
+};
+
 class Socket : noncopyable
 {
 public:
@@ -20,6 +53,12 @@ public:
 
     ~Socket();
     int fd() const { return sockfd_; }
+    // return true if success.
+    bool getTcpInfo(struct tcp_info*) const;
+    //格式化rtt、cwnd、重传等主要指标，失败返回false
+    bool getTcpInfoString(char* buf, int len) const;
+    //内核发送队列中尚未被对端确认的字节数(SIOCOUTQ)，失败返回-1
+    int getSendQueueBytes() const;
     /// abort if address in use
     void bindAddress(const InetAddress& localaddr);
     /// abort if address in use
@@ -32,6 +71,63 @@ public:
     //是否重用端口号
     void setReuseAddr(bool on);
 
+    void shutdownWrite();
+
+    ///
+    /// SO_LINGER, setLinger(true, 0) makes close() send RST instead of FIN
+    ///
+    void setLinger(bool on, int seconds);
+
+    ///
+    /// Enable/disable SO_REUSEPORT
+    ///
+    //多个进程/线程可以bind同一个端口，由内核分发新连接
+    void setReusePort(bool on);
+
+    ///
+    /// Enable/disable TCP_NODELAY (disable/enable Nagle's algorithm).
+    ///
+    void setTcpNoDelay(bool on);
+
+    ///
+    /// Enable/disable SO_KEEPALIVE
+    ///
+    void setKeepAlive(bool on);
+    //空闲idle秒后开始探测，每interval秒一次，count次无响应则断开
+    void setKeepAliveParams(int idle, int interval, int count);
+
+    //SO_SNDBUF/SO_RCVBUF
+    void setSendBufferSize(int bytes);
+    void setRecvBufferSize(int bytes);
+
+    ///
+    /// Enable/disable TCP_QUICKACK, the kernel may reset it after each ack
+    ///
+    void setQuickAck(bool on);
+
+    ///
+    /// TCP_DEFER_ACCEPT on listening socket, wake up accept() only when data arrives
+    ///
+    void setDeferAccept(int seconds);
+
+    ///
+    /// TCP_FASTOPEN on listening socket, must be set before listen()
+    ///
+    void setFastOpen(int queueLength);
+
+    ///
+    /// SO_BUSY_POLL, microseconds to busy poll on the device queue
+    ///
+    void setBusyPoll(int usec);
+
+    void applyOptions(const SocketOptions& options);
+
+    ///
+    /// Enable/disable SO_ZEROCOPY, returns false if the kernel refuses it
+    ///
+    //开启后才能用MSG_ZEROCOPY发送，需要Linux 4.14以上
+    bool setZeroCopy(bool on);
+
 private:
     const int sockfd_;
 };
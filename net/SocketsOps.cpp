@@ -1,9 +1,11 @@
 #include "SocketsOps.h"
+#include "InetAddress.h"
 #include "../base/Logging.h"
 
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>  // snprintf
+#include <string.h>  // memcmp
 #include <strings.h>  // bzero
 #include <sys/socket.h>
 #include <unistd.h>
@@ -14,12 +16,7 @@ namespace
 {
 typedef struct sockaddr SA;
 
-const SA* sockaddr_cast(const struct sockaddr_in* addr)
-{
-    return static_cast<const SA*>(implicit_cast<const void*>(addr));
-}
-
-SA* sockaddr_cast(struct sockaddr_in* addr)
+SA* sockaddr_cast(struct sockaddr_storage* addr)
 {
     return static_cast<SA*>(implicit_cast<void*>(addr));
 }
@@ -41,10 +38,12 @@ void setNonBlockAndCloseOnExec(int sockfd)
 
 }
 //返回一个非阻塞和close-on-exec的文件描述符
-int sockets::createNonblockingOrDie(){
+int sockets::createNonblockingOrDie(sa_family_t family){
 // socket
+    //Unix domain socket的protocol只能是0
+    const int protocol = (family == AF_UNIX) ? 0 : IPPROTO_TCP;
 #if VALGRIND
-    int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    int sockfd = ::socket(family, SOCK_STREAM, protocol);
     if (sockfd < 0)
     {
         LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -52,9 +51,9 @@ int sockets::createNonblockingOrDie(){
     setNonBlockAndCloseOnExec(sockfd);
 #else
     //after Linux 2.6.27
-    int sockfd = ::socket(AF_INET,
+    int sockfd = ::socket(family,
                         SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
-                        IPPROTO_TCP);
+                        protocol);
     if (sockfd < 0)
     {
         LOG_SYSFATAL << "sockets::createNonblockingOrDie";
@@ -63,8 +62,20 @@ int sockets::createNonblockingOrDie(){
     return sockfd;
 }
 
-void sockets::bindOrDie(int sockfd, const struct sockaddr_in& addr){
-    int ret = ::bind(sockfd, sockaddr_cast(&addr), sizeof addr);
+int sockets::createUdpNonblockingOrDie(sa_family_t family)
+{
+    int sockfd = ::socket(family,
+                          SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          IPPROTO_UDP);
+    if (sockfd < 0)
+    {
+        LOG_SYSFATAL << "sockets::createUdpNonblockingOrDie";
+    }
+    return sockfd;
+}
+
+void sockets::bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen){
+    int ret = ::bind(sockfd, addr, addrlen);
     if (ret < 0)
     {
         LOG_SYSFATAL << "sockets::bindOrDie";
@@ -77,15 +88,15 @@ void sockets::listenOrDie(int sockfd){
         LOG_SYSFATAL << "sockets::listenOrDie";
     }
 }
-int  sockets::accept(int sockfd, struct sockaddr_in* addr){
-    socklen_t addrlen = sizeof *addr;
+int  sockets::accept(int sockfd, struct sockaddr_storage* addr, socklen_t* addrlen){
+    *addrlen = sizeof *addr;
 #if VALGRIND
-    int connfd = ::accept(sockfd, sockaddr_cast(addr), &addrlen);
+    int connfd = ::accept(sockfd, sockaddr_cast(addr), addrlen);
     setNonBlockAndCloseOnExec(connfd);
 #else
     //after Linux 2.6.27
     int connfd = ::accept4(sockfd, sockaddr_cast(addr),
-                         &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                         addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
 #endif
     if (connfd < 0)
     {
@@ -120,6 +131,10 @@ int  sockets::accept(int sockfd, struct sockaddr_in* addr){
     }
     return connfd;
 }
+int sockets::connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen)
+{
+    return ::connect(sockfd, addr, addrlen);
+}
 void sockets::close(int sockfd){
     if (::close(sockfd) < 0)
     {
@@ -127,12 +142,79 @@ void sockets::close(int sockfd){
     }
 }
 
+void sockets::shutdownWrite(int sockfd)
+{
+    if (::shutdown(sockfd, SHUT_WR) < 0)
+    {
+        LOG_SYSERR << "sockets::shutdownWrite";
+    }
+}
+
+int sockets::getSocketError(int sockfd)
+{
+    int optval;
+    socklen_t optlen = sizeof optval;
+
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
+    {
+        return errno;
+    }
+    else
+    {
+        return optval;
+    }
+}
+
+InetAddress sockets::getLocalAddr(int sockfd)
+{
+    struct sockaddr_storage localaddr;
+    bzero(&localaddr, sizeof localaddr);
+    socklen_t addrlen = sizeof(localaddr);
+    if (::getsockname(sockfd, sockaddr_cast(&localaddr), &addrlen) < 0)
+    {
+        LOG_SYSERR << "sockets::getLocalAddr";
+    }
+    return InetAddress(localaddr, addrlen);
+}
+
+InetAddress sockets::getPeerAddr(int sockfd)
+{
+    struct sockaddr_storage peeraddr;
+    bzero(&peeraddr, sizeof peeraddr);
+    socklen_t addrlen = sizeof(peeraddr);
+    if (::getpeername(sockfd, sockaddr_cast(&peeraddr), &addrlen) < 0)
+    {
+        LOG_SYSERR << "sockets::getPeerAddr";
+    }
+    return InetAddress(peeraddr, addrlen);
+}
+/*
+只有TCP会连上自己，Unix domain socket总是返回false
+*/
+bool sockets::isSelfConnect(int sockfd)
+{
+    InetAddress localaddr = getLocalAddr(sockfd);
+    InetAddress peeraddr = getPeerAddr(sockfd);
+    if (localaddr.family() != peeraddr.family() || localaddr.isUnix())
+    {
+        return false;
+    }
+    return localaddr.getSockLen() == peeraddr.getSockLen()
+        && memcmp(localaddr.getSockAddr(), peeraddr.getSockAddr(), localaddr.getSockLen()) == 0;
+}
+
 void sockets::toHostPort(char* buf, size_t size,const struct sockaddr_in& addr){
     char host[INET_ADDRSTRLEN] = "INVALID";
     ::inet_ntop(AF_INET, &addr.sin_addr, host, sizeof host);
     uint16_t port = sockets::networkToHost16(addr.sin_port);
     snprintf(buf, size, "%s:%u", host, port);
 }
+void sockets::toHostPort(char* buf, size_t size,const struct sockaddr_in6& addr){
+    char host[INET6_ADDRSTRLEN] = "INVALID";
+    ::inet_ntop(AF_INET6, &addr.sin6_addr, host, sizeof host);
+    uint16_t port = sockets::networkToHost16(addr.sin6_port);
+    snprintf(buf, size, "[%s]:%u", host, port);
+}
 void sockets::fromHostPort(const char* ip, uint16_t port,struct sockaddr_in* addr){
     addr->sin_family = AF_INET;
     addr->sin_port = hostToNetwork16(port);
@@ -141,3 +223,11 @@ void sockets::fromHostPort(const char* ip, uint16_t port,struct sockaddr_in* add
         LOG_SYSERR << "sockets::fromHostPort";
     }
 }
+void sockets::fromHostPort(const char* ip, uint16_t port,struct sockaddr_in6* addr){
+    addr->sin6_family = AF_INET6;
+    addr->sin6_port = hostToNetwork16(port);
+    if (::inet_pton(AF_INET6, ip, &addr->sin6_addr) <= 0)
+    {
+        LOG_SYSERR << "sockets::fromHostPort";
+    }
+}
@@ -3,11 +3,13 @@
 
 #include <arpa/inet.h>
 #include <endian.h>
+#include <sys/socket.h>
 
 namespace muduo
 {
 namespace net
 {
+class InetAddress;
 namespace sockets
 {
 //主机序转网络序
@@ -41,20 +43,40 @@ inline uint16_t networkToHost16(uint16_t net16)
   return ntohs(net16);
 }
 //对socket中socket的封装，生成一个非阻塞和close-on-exec的文件描述符
-int createNonblockingOrDie();
+//family为AF_INET、AF_INET6或AF_UNIX
+int createNonblockingOrDie(sa_family_t family = AF_INET);
+//非阻塞和close-on-exec的UDP socket
+int createUdpNonblockingOrDie(sa_family_t family = AF_INET);
 //对socket中bind的封装
-void bindOrDie(int sockfd, const struct sockaddr_in& addr);
+void bindOrDie(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 //对socket中listen的封装
 void listenOrDie(int sockfd);
 //对socket中accept的封装
-int  accept(int sockfd, struct sockaddr_in* addr);
+//*addrlen返回对端地址的实际长度
+int  accept(int sockfd, struct sockaddr_storage* addr, socklen_t* addrlen);
+//对socket中connect的封装，非阻塞socket通常返回-1且errno为EINPROGRESS
+int connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 //对socket中close的封装
 void close(int sockfd);
+//关闭写方向，发送FIN
+void shutdownWrite(int sockfd);
+//取出并清除socket上的待处理错误(SO_ERROR)
+int getSocketError(int sockfd);
+//返回sockfd绑定的本地地址
+InetAddress getLocalAddr(int sockfd);
+//返回sockfd连接的对端地址
+InetAddress getPeerAddr(int sockfd);
+//本地地址和对端地址相同，即连上了自己(目的端口落在本机临时端口范围内且无人监听时可能发生)
+bool isSelfConnect(int sockfd);
 
 void toHostPort(char* buf, size_t size,
                 const struct sockaddr_in& addr);
+void toHostPort(char* buf, size_t size,
+                const struct sockaddr_in6& addr);
 void fromHostPort(const char* ip, uint16_t port,
                   struct sockaddr_in* addr);
+void fromHostPort(const char* ip, uint16_t port,
+                  struct sockaddr_in6* addr);
 }//sockets
 }//net
 }//muduo
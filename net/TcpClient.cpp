@@ -0,0 +1,145 @@
+#include "TcpClient.h"
+
+#include "../base/Logging.h"
+#include "EventLoop.h"
+#include "SocketsOps.h"
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+/*
+TcpClient析构时连接可能还没断开，之后的关闭回调不能再访问TcpClient，
+只需要把连接交给connectDestroyed
+*/
+void removeConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+    loop->queueInLoop(boost::bind(&TcpConnection::connectDestroyed, conn));
+}
+}
+
+TcpClient::TcpClient(EventLoop* loop,
+                     const InetAddress& serverAddr,
+                     const std::string& name)
+  : loop_(loop),
+    connector_(new Connector(loop, serverAddr)),
+    name_(name),
+    namePrefix_(new std::string(name + ":" + serverAddr.toHostPort())),
+    retry_(false),
+    connect_(true),
+    nextConnId_(1)
+{
+    connector_->setNewConnectionCallback(
+        boost::bind(&TcpClient::newConnection, this, _1));
+    LOG_INFO << "TcpClient::TcpClient[" << name_
+             << "] - connector " << get_pointer(connector_);
+}
+
+TcpClient::~TcpClient()
+{
+    LOG_INFO << "TcpClient::~TcpClient[" << name_
+             << "] - connector " << get_pointer(connector_);
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        MutexLockGuard lock(mutex_);
+        unique = connection_.unique();
+        conn = connection_;
+    }
+    if (conn)
+    {
+        assert(loop_ == conn->getLoop());
+        // FIXME: not 100% safe, if we are in different thread
+        CloseCallback cb = boost::bind(&::removeConnection, loop_, _1);
+        loop_->runInLoop(
+            boost::bind(&TcpConnection::setCloseCallback, conn, cb));
+        if (unique)
+        {
+            conn->forceClose();
+        }
+    }
+    else
+    {
+        //Connector由自己的回调持有，重试的定时器到期后才释放
+        connector_->stop();
+    }
+}
+
+void TcpClient::connect()
+{
+    // FIXME: check state
+    LOG_INFO << "TcpClient::connect[" << name_ << "] - connecting to "
+             << connector_->serverAddress().toHostPort();
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect()
+{
+    connect_ = false;
+
+    {
+        MutexLockGuard lock(mutex_);
+        if (connection_)
+        {
+            connection_->shutdown();
+        }
+    }
+}
+
+void TcpClient::stop()
+{
+    connect_ = false;
+    connector_->stop();
+}
+
+void TcpClient::newConnection(int sockfd)
+{
+    loop_->assertInLoopThread();
+    InetAddress peerAddr(sockets::getPeerAddr(sockfd));
+    InetAddress localAddr(sockets::getLocalAddr(sockfd));
+    uint64_t connId = nextConnId_++;
+    // 与TcpServer一样从本loop的pool分配
+    TcpConnectionPtr conn(boost::allocate_shared<TcpConnection>(
+        PoolAllocator<TcpConnection>(loop_->connectionPool()),
+        loop_, connId, namePrefix_, sockfd, localAddr, peerAddr));
+
+    conn->setSocketOptions(connectionOptions_);
+    conn->setConnectionCallback(connectionCallback_);
+    conn->setMessageCallback(messageCallback_);
+    conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setCloseCallback(
+        boost::bind(&TcpClient::removeConnection, this, _1)); // FIXME: unsafe
+    {
+        MutexLockGuard lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablished();
+}
+/*
+连接断开后，如果开启了重试并且用户没有主动disconnect()，就用Connector重新连接，
+restart()会把重试间隔恢复为初始值，等一个初始间隔后再连接
+*/
+void TcpClient::removeConnection(const TcpConnectionPtr& conn)
+{
+    loop_->assertInLoopThread();
+    assert(loop_ == conn->getLoop());
+
+    {
+        MutexLockGuard lock(mutex_);
+        assert(connection_ == conn);
+        connection_.reset();
+    }
+
+    loop_->queueInLoop(boost::bind(&TcpConnection::connectDestroyed, conn));
+    if (retry_ && connect_)
+    {
+        LOG_INFO << "TcpClient::connect[" << name_ << "] - Reconnecting to "
+                 << connector_->serverAddress().toHostPort();
+        connector_->restart();
+    }
+}
@@ -0,0 +1,96 @@
+/*
+TcpClient主动连接一个服务器并管理这一个连接，是TcpServer的对应物。
+与TcpServer共用EventLoop、TcpConnection和各种回调，上游连接和下游连接可以跑在同一组IO线程里
+*/
+#ifndef MUDUO_NET_TCPCLIENT_H
+#define MUDUO_NET_TCPCLIENT_H
+
+#include "../base/noncopyable.h"
+#include "../base/Mutex.h"
+#include "Callbacks.h"
+#include "Connector.h"
+#include "Socket.h"
+#include "TcpConnection.h"
+
+#include <string>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+class TcpClient : noncopyable
+{
+public:
+    TcpClient(EventLoop* loop,
+              const InetAddress& serverAddr,
+              const std::string& name);
+    ~TcpClient();  // force out-line dtor, for scoped_ptr members.
+
+    void connect();
+    //半关闭当前连接，不再重连
+    void disconnect();
+    //放弃正在进行的连接或重试
+    void stop();
+
+    TcpConnectionPtr connection() const
+    {
+        MutexLockGuard lock(mutex_);
+        return connection_;
+    }
+
+    EventLoop* getLoop() const { return loop_; }
+    const std::string& name() const { return name_; }
+    bool retry() const { return retry_; }
+    //连接建立后又断开时自动重连，重试间隔见Connector
+    void enableRetry() { retry_ = true; }
+    //连接失败时的重试间隔，从initMs开始每次翻倍，最多maxMs，需要在connect()之前设置
+    void setRetryDelay(int initMs, int maxMs)
+    { connector_->setRetryDelay(initMs, maxMs); }
+
+    /// Set connection callback.
+    /// Not thread safe.
+    void setConnectionCallback(const ConnectionCallback& cb)
+    { connectionCallback_ = cb; }
+
+    /// Set message callback.
+    /// Not thread safe.
+    void setMessageCallback(const MessageCallback& cb)
+    { messageCallback_ = cb; }
+
+    /// Set write complete callback.
+    /// Not thread safe.
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb)
+    { writeCompleteCallback_ = cb; }
+
+    //新连接使用的socket选项
+    void setConnectionOptions(const SocketOptions& options)
+    { connectionOptions_ = options; }
+
+private:
+    /// Not thread safe, but in loop
+    void newConnection(int sockfd);
+    /// Not thread safe, but in loop
+    void removeConnection(const TcpConnectionPtr& conn);
+
+    EventLoop* loop_;
+    ConnectorPtr connector_; // avoid revealing Connector
+    const std::string name_;
+    const TcpConnection::NamePrefixPtr namePrefix_;
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    SocketOptions connectionOptions_;
+    bool retry_;   // atomic
+    bool connect_; // atomic
+    // always in loop thread
+    uint64_t nextConnId_;
+    mutable MutexLock mutex_;
+    TcpConnectionPtr connection_; // @GuardedBy mutex_
+};
+
+}//net
+}//muduo
+#endif
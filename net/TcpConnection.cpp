@@ -7,61 +7,355 @@
 #include "SocketsOps.h"
 
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 
 #include <errno.h>
+#include <inttypes.h>
+#include <netinet/tcp.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 using namespace muduo;
 using namespace muduo::net;
+
+const size_t TcpConnection::kZeroCopyThreshold;
+
 TcpConnection::TcpConnection(EventLoop* loop,
-                             const std::string& nameArg,
+                             uint64_t id,
+                             const NamePrefixPtr& namePrefix,
                              int sockfd,
                              const InetAddress& localAddr,
                              const InetAddress& peerAddr)
   : loop_(loop),
-    name_(nameArg),
+    id_(id),
+    namePrefix_(namePrefix),
     state_(kConnecting),
-    socket_(new Socket(sockfd)),
-    channel_(new Channel(loop, sockfd)),
+    zeroCopy_(false),
+    reading_(true),
+    autoCork_(false),
+    corkedFlushPending_(false),
+    socket_(sockfd),
+    channel_(loop, sockfd),
     localAddr_(localAddr),
-    peerAddr_(peerAddr)
+    peerAddr_(peerAddr),
+    highWaterMark_(64*1024*1024),
+    inputHighWaterMark_(0),
+    created_(Timestamp::now()),
+    loopStats_(loop->trafficCounters()),
+    serverStats_(NULL),
+    timingWheel_(NULL),
+    bufferPool_(loop->bufferPool()),
+    inputBuffer_(bufferPool_->take()),
+    outputBuffer_(bufferPool_.get())
 {
-    LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
+    LOG_DEBUG << "TcpConnection::ctor[" << name() << "] at " << this
             << " fd=" << sockfd;
-    channel_->setReadCallback(boost::bind(&TcpConnection::handleRead, this,_1));
-    channel_->setWriteCallback(
+    channel_.setReadCallback(boost::bind(&TcpConnection::handleRead, this,_1));
+    channel_.setWriteCallback(
         boost::bind(&TcpConnection::handleWrite, this));
-    channel_->setCloseCallback(
+    channel_.setCloseCallback(
         boost::bind(&TcpConnection::handleClose, this));
-    channel_->setErrorCallback(
+    channel_.setErrorCallback(
         boost::bind(&TcpConnection::handleError, this));
 }
 TcpConnection::~TcpConnection()
 {
-    LOG_DEBUG << "TcpConnection::dtor[" <<  name_ << "] at " << this
-            << " fd=" << channel_->fd();
+    LOG_DEBUG << "TcpConnection::dtor[" << name() << "] at " << this
+            << " fd=" << channel_.fd();
+    bufferPool_->recycle(std::move(inputBuffer_));
+}
+//不经过StringPiece，它的长度是int，2GiB以上的len会被截断
+void TcpConnection::send(const void* message, size_t len){
+    if(state_==kConnected){
+        if(loop_->isInLoopThread()){
+            sendInLoop(message, len);
+        }
+        else{
+            send(boost::make_shared<const std::string>(static_cast<const char*>(message), len));
+        }
+    }
+}
+void TcpConnection::send(const StringPiece& message){
+    if(state_==kConnected){
+        if(loop_->isInLoopThread()){
+            sendInLoop(message.data(), message.size());
+        }
+        else{
+            send(boost::make_shared<const std::string>(message.data(), message.size()));
+        }
+    }
+}
+void TcpConnection::send(const char* message){
+    send(StringPiece(message));
 }
 void TcpConnection::send(const std::string& message){
     if(state_==kConnected){
         if(loop_->isInLoopThread()){
-            sendInLoop(message);
+            sendInLoop(message.data(), message.size());
+        }
+        else{
+            send(boost::make_shared<const std::string>(message));
+        }
+    }
+}
+void TcpConnection::send(std::string&& message){
+    if(state_==kConnected){
+        if(loop_->isInLoopThread()){
+            if (zeroCopy_ && message.size() >= kZeroCopyThreshold) {
+                sendPayloadInLoop(boost::make_shared<const std::string>(std::move(message)));
+                return;
+            }
+            size_t nwrote = writeDirectly(message.data(), message.size());
+            //没写完的部分连同message一起移动到PayloadPtr里，队列只引用它
+            if (nwrote < message.size()) {
+                size_t oldLen = outputBuffer_.readableBytes();
+                outputBuffer_.append(boost::make_shared<const std::string>(std::move(message)), nwrote);
+                outputQueued(oldLen);
+            }
         }
         else{
-            loop_->runInLoop(boost::bind(&TcpConnection::sendInLoop,this,message));
+            send(boost::make_shared<const std::string>(std::move(message)));
+        }
+    }
+}
+void TcpConnection::send(Buffer* buf){
+    if(state_==kConnected){
+        if(loop_->isInLoopThread()){
+            sendBufferInLoop(buf);
+        }
+        else{
+            //交换到堆上的Buffer里再转交给IO线程
+            boost::shared_ptr<Buffer> pending(boost::make_shared<Buffer>());
+            pending->swap(*buf);
+            void (TcpConnection::*fp)(const boost::shared_ptr<Buffer>&) = &TcpConnection::sendBufferInLoop;
+            loop_->runInLoop(boost::bind(fp,this,pending));
+        }
+    }
+}
+void TcpConnection::send(const PayloadPtr& payload){
+    if(state_==kConnected){
+        if(loop_->isInLoopThread()){
+            sendPayloadInLoop(payload);
+        }
+        else{
+            loop_->runInLoop(boost::bind(&TcpConnection::sendPayloadInLoop,this,payload));
+        }
+    }
+}
+void TcpConnection::sendFile(int fd, off_t offset, size_t length){
+    if(state_==kConnected){
+        int filefd = ::dup(fd);
+        if (filefd < 0) {
+            LOG_SYSERR << "TcpConnection::sendFile";
+            return;
+        }
+        if(loop_->isInLoopThread()){
+            sendFileInLoop(filefd, offset, length);
+        }
+        else{
+            //filefd由sendFileInLoop负责关闭，连接必须活到它执行的时候
+            loop_->runInLoop(boost::bind(&TcpConnection::sendFileInLoop,shared_from_this(),filefd,offset,length));
+        }
+    }
+}
+void TcpConnection::sendInLoop(const void* data, size_t len){
+    loop_->assertInLoopThread();
+    if (zeroCopy_ && len >= kZeroCopyThreshold) {
+        //拷进队列后用MSG_ZEROCOPY发送，省掉内核里的那次拷贝
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(static_cast<const char*>(data), len);
+        flushQueuedInLoop(oldLen);
+        return;
+    }
+    size_t nwrote = writeDirectly(data, len);
+    //输出剩下的内容
+    if (nwrote < len) {
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(static_cast<const char*>(data)+nwrote, len-nwrote);
+        outputQueued(oldLen);
+    }
+}
+void TcpConnection::sendBufferInLoop(const boost::shared_ptr<Buffer>& buf){
+    sendBufferInLoop(get_pointer(buf));
+}
+void TcpConnection::sendBufferInLoop(Buffer* buf){
+    loop_->assertInLoopThread();
+    if (zeroCopy_ && buf->readableBytes() >= kZeroCopyThreshold) {
+        //整块交换进队列，不拷贝，由队列用MSG_ZEROCOPY发送
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(buf);
+        flushQueuedInLoop(oldLen);
+        return;
+    }
+    size_t nwrote = writeDirectly(buf->peek(), buf->readableBytes());
+    buf->retrieve(nwrote);
+    if (buf->readableBytes() > 0) {
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(buf);
+        outputQueued(oldLen);
+    }
+    else {
+        buf->retrieveAll();
+    }
+}
+void TcpConnection::sendPayloadInLoop(const PayloadPtr& payload){
+    loop_->assertInLoopThread();
+    if (zeroCopy_ && payload->size() >= kZeroCopyThreshold) {
+        //交给队列用MSG_ZEROCOPY发送，payload在内核通知完成前一直被引用
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(payload, 0);
+        flushQueuedInLoop(oldLen);
+        return;
+    }
+    size_t nwrote = writeDirectly(payload->data(), payload->size());
+    //剩下的内容只保存引用
+    if (nwrote < payload->size()) {
+        size_t oldLen = outputBuffer_.readableBytes();
+        outputBuffer_.append(payload, nwrote);
+        outputQueued(oldLen);
+    }
+}
+/*
+文件区间总是先入队，保证排在之前send()的数据之后；
+如果之前没有待发送的数据，就立刻sendfile一次，剩下的等可写时再发
+*/
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length){
+    loop_->assertInLoopThread();
+    //跨线程调用时，执行前连接可能已经断开或正在关闭，这时文件不会再入队，由这里关闭
+    if (state_ != kConnected) {
+        LOG_WARN << "TcpConnection::sendFileInLoop [" << name() << "] - not connected, give up sending";
+        sockets::close(fd);
+        return;
+    }
+    size_t oldLen = outputBuffer_.readableBytes();
+    outputBuffer_.appendFile(fd, offset, length);
+    flushQueuedInLoop(oldLen);
+}
+void TcpConnection::flushQueuedInLoop(size_t oldLen){
+    if (autoCork_) {
+        scheduleCorkedFlush();
+    }
+    else if (oldLen == 0 && !channel_.isWriting() && !outputBuffer_.empty()) {
+        int savedErrno = 0;
+        if (writeQueued(&savedErrno) < 0
+            && savedErrno != EWOULDBLOCK) {
+            errno = savedErrno;
+            LOG_SYSERR << "TcpConnection::flushQueuedInLoop";
+        }
+        if (outputBuffer_.empty()) {
+            if (writeCompleteCallback_) {
+                loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            return;
+        }
+    }
+    outputQueued(oldLen);
+}
+/*
+只在长度从水位以下越过水位时通知一次，回调放到queueInLoop中执行，
+这样用户在回调里再调用send()也不会重入sendInLoop
+*/
+void TcpConnection::outputQueued(size_t oldLen){
+    size_t newLen = outputBuffer_.readableBytes();
+    stats_.updatePeakOutput(newLen);
+    loopStats_->updatePeakOutput(newLen);
+    if (serverStats_) serverStats_->updatePeakOutput(newLen);
+    if (newLen >= highWaterMark_
+        && oldLen < highWaterMark_
+        && highWaterMarkCallback_) {
+        loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), newLen));
+    }
+    //等待合并发送时由flushCorkedInLoop决定是否关注可写事件
+    if (!channel_.isWriting() && !corkedFlushPending_) {
+        channel_.enableWriting();
+    }
+}
+void TcpConnection::setAutoCork(bool on){
+    loop_->assertInLoopThread();
+    autoCork_ = on;
+}
+void TcpConnection::scheduleCorkedFlush(){
+    if (!corkedFlushPending_ && !channel_.isWriting()) {
+        corkedFlushPending_ = true;
+        loop_->queueInLoop(boost::bind(&TcpConnection::flushCorkedInLoop, shared_from_this()));
+    }
+}
+/*
+在doPendingFunctors()中执行，这时本轮所有的事件回调都已返回，
+它们send()的数据已经按顺序排在输出队列里，一次writev就能全部交给内核
+*/
+void TcpConnection::flushCorkedInLoop(){
+    loop_->assertInLoopThread();
+    corkedFlushPending_ = false;
+    if (state_ == kDisconnected || channel_.isWriting() || outputBuffer_.empty()) {
+        return;
+    }
+    int savedErrno = 0;
+    if (writeQueued(&savedErrno) < 0
+        && savedErrno != EWOULDBLOCK) {
+        errno = savedErrno;
+        LOG_SYSERR << "TcpConnection::flushCorkedInLoop";
+    }
+    if (outputBuffer_.empty()) {
+        if (writeCompleteCallback_) {
+            loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        if (state_ == kDisconnecting) {
+            shutdownInLoop();
         }
     }
+    else {
+        channel_.enableWriting();
+    }
 }
-void TcpConnection::sendInLoop(const std::string& message){
+bool TcpConnection::setZeroCopy(bool on){
     loop_->assertInLoopThread();
+    if (on && !socket_.setZeroCopy(true)) {
+        LOG_SYSERR << "TcpConnection::setZeroCopy [" << name() << "]";
+        return false;
+    }
+    zeroCopy_ = on;
+    outputBuffer_.setZeroCopyThreshold(on ? kZeroCopyThreshold : 0);
+    return true;
+}
+ssize_t TcpConnection::writeQueued(int* savedErrno){
+    size_t len = outputBuffer_.readableBytes();
+    ssize_t n = outputBuffer_.writeFd(channel_.fd(), savedErrno);
+    countWrite(n, len, *savedErrno);
+    return n;
+}
+//partial按整个待写长度算，writev一次没写完队列也记为partial
+void TcpConnection::countWrite(ssize_t n, size_t len, int savedErrno){
+    if (n >= 0) {
+        bool partial = implicit_cast<size_t>(n) < len;
+        stats_.addWrite(n, partial);
+        loopStats_->addWrite(n, partial);
+        if (serverStats_) serverStats_->addWrite(n, partial);
+    }
+    else if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+        stats_.addEagain();
+        loopStats_->addEagain();
+        if (serverStats_) serverStats_->addEagain();
+    }
+}
+size_t TcpConnection::writeDirectly(const void* data, size_t len){
     ssize_t nwrote = 0;
+    if (autoCork_) {
+        scheduleCorkedFlush();
+        return 0;
+    }
     // if no thing in output queue, try writing directly
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        nwrote = ::write(channel_->fd(), message.data(), message.size());
+    if (!channel_.isWriting() && outputBuffer_.readableBytes() == 0) {
+        nwrote = ::write(channel_.fd(), data, len);
+        countWrite(nwrote, len, errno);
         if (nwrote >= 0) {
-            if (implicit_cast<size_t>(nwrote) < message.size()) {
+            if (implicit_cast<size_t>(nwrote) < len) {
                 LOG_TRACE << "I am going to write more data";
             }
+            else if (writeCompleteCallback_) {
+                loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+            }
         } else {
             nwrote = 0;
             if (errno != EWOULDBLOCK) {
@@ -70,13 +364,7 @@ void TcpConnection::sendInLoop(const std::string& message){
         }
     }
     assert(nwrote >= 0);
-    //输出剩下的内容
-    if (implicit_cast<size_t>(nwrote) < message.size()) {
-        outputBuffer_.append(message.data()+nwrote, message.size()-nwrote);
-        if (!channel_->isWriting()) {
-            channel_->enableWriting();
-        }
-    }
+    return implicit_cast<size_t>(nwrote);
 }
 void TcpConnection::shutdown(){
     if (state_ == kConnected)
@@ -88,10 +376,123 @@ void TcpConnection::shutdown(){
 }
 void TcpConnection::shutdownInLoop(){
     loop_->assertInLoopThread();
-    if (!channel_->isWriting())
+    //合并发送时队列里可能还有数据而尚未关注可写事件
+    if (!channel_.isWriting() && outputBuffer_.empty())
     {
         // we are not writing
-        socket_->shutdownWrite();
+        socket_.shutdownWrite();
+    }
+}
+std::string TcpConnection::name() const{
+    char buf[32];
+    snprintf(buf, sizeof buf, "#%" PRIu64, id_);
+    return *namePrefix_ + buf;
+}
+double TcpConnection::age() const{
+    return timeDifference(Timestamp::now(), created_);
+}
+bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const{
+    return socket_.getTcpInfo(tcpi);
+}
+std::string TcpConnection::getTcpInfoString() const{
+    char buf[1024];
+    buf[0] = '\0';
+    socket_.getTcpInfoString(buf, sizeof buf);
+    return buf;
+}
+void TcpConnection::forceClose(bool abortive){
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnecting);
+        loop_->queueInLoop(boost::bind(&TcpConnection::forceCloseInLoop, shared_from_this(), abortive));
+    }
+}
+namespace
+{
+//定时器只持有weak_ptr，连接先断开的话什么也不做
+void forceCloseIfAlive(const boost::weak_ptr<TcpConnection>& weakConn, bool abortive)
+{
+    TcpConnectionPtr conn(weakConn.lock());
+    if (conn)
+    {
+        conn->forceClose(abortive);
+    }
+}
+}
+void TcpConnection::forceCloseWithDelay(double seconds, bool abortive){
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        if (state_ == kConnected)
+        {
+            setState(kDisconnecting);
+            loop_->runInLoop(boost::bind(&TcpConnection::shutdownInLoop, shared_from_this()));
+        }
+        // 只持有weak_ptr，连接先销毁时定时器到期什么也不做，不必cancel
+        loop_->runAfter(seconds,
+            boost::bind(&forceCloseIfAlive, boost::weak_ptr<TcpConnection>(shared_from_this()), abortive));
+    }
+}
+void TcpConnection::forceCloseInLoop(bool abortive){
+    loop_->assertInLoopThread();
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        LOG_DEBUG << "TcpConnection::forceCloseInLoop [" << name() << "] drops "
+                  << outputBuffer_.readableBytes() << " bytes";
+        if (abortive)
+        {
+            socket_.setLinger(true, 0);
+        }
+        outputBuffer_.retrieveAll();
+        // as if we received 0 byte in handleRead();
+        handleClose();
+    }
+}
+void TcpConnection::setTcpNoDelay(bool on){
+    socket_.setTcpNoDelay(on);
+}
+void TcpConnection::setKeepAlive(bool on){
+    socket_.setKeepAlive(on);
+}
+void TcpConnection::setSocketOptions(const SocketOptions& options){
+    if (localAddr_.isUnix()) {
+        //Unix domain socket没有TCP层，只保留SOL_SOCKET的选项，否则每次都会失败并打印SYSERR
+        SocketOptions socketLevel(options);
+        socketLevel.tcpNoDelay = false;
+        socketLevel.keepAlive = false;
+        socketLevel.quickAck = false;
+        socket_.applyOptions(socketLevel);
+    }
+    else {
+        socket_.applyOptions(options);
+    }
+}
+void TcpConnection::startRead(){
+    loop_->runInLoop(boost::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+/*
+连接已经关闭时channel已从Poller中移除(或即将移除)，不能再enableReading()
+*/
+void TcpConnection::startReadInLoop(){
+    loop_->assertInLoopThread();
+    if (state_ != kConnected && state_ != kDisconnecting) {
+        return;
+    }
+    if (!reading_ || !channel_.isReading()) {
+        channel_.enableReading();
+        reading_ = true;
+    }
+}
+void TcpConnection::stopRead(){
+    loop_->runInLoop(boost::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+void TcpConnection::stopReadInLoop(){
+    loop_->assertInLoopThread();
+    if (state_ != kConnected && state_ != kDisconnecting) {
+        return;
+    }
+    if (reading_ || channel_.isReading()) {
+        channel_.disableReading();
+        reading_ = false;
     }
 }
 void TcpConnection::connectEstablished()
@@ -99,7 +500,7 @@ void TcpConnection::connectEstablished()
     loop_->assertInLoopThread();
     assert(state_ == kConnecting);
     setState(kConnected);
-    channel_->enableReading();
+    channel_.enableReading();
 
     connectionCallback_(shared_from_this());
 }
@@ -110,26 +511,54 @@ void TcpConnection::connectEstablished()
 void TcpConnection::connectDestroyed()
 {
     loop_->assertInLoopThread();
-    assert(state_ == kConnected|| state_ == kDisconnecting);
-    setState(kDisconnected);
-    channel_->disableAll();
-    connectionCallback_(shared_from_this());
-
-    loop_->removeChannel(get_pointer(channel_));
+    //经由handleClose()时已经通知过用户
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnected);
+        channel_.disableAll();
+        connectionCallback_(shared_from_this());
+    }
+    loop_->removeChannel(&channel_);
 }
 //会检查read()的返回值，根据返回值分别调用messageCallback_,handleClose,handleError()
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
     int savedErrno=0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(),&savedErrno);
+    ssize_t n = inputBuffer_.readFd(channel_.fd(),&savedErrno);
+    if (n >= 0) {
+        int64_t inputBytes = inputBuffer_.readableBytes();
+        stats_.addRead(n);
+        stats_.updatePeakInput(inputBytes);
+        loopStats_->addRead(n);
+        loopStats_->updatePeakInput(inputBytes);
+        if (serverStats_) {
+            serverStats_->addRead(n);
+            serverStats_->updatePeakInput(inputBytes);
+        }
+    }
     if (n > 0) {
+        if (timingWheel_) {
+            timingWheel_->touch(timingWheelEntry_);
+        }
         messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        if (inputHighWaterMark_ > 0
+            && inputBuffer_.readableBytes() >= inputHighWaterMark_
+            && reading_) {
+            LOG_DEBUG << "TcpConnection::handleRead [" << name() << "] stop reading, "
+                      << inputBuffer_.readableBytes() << " bytes pending";
+            stopReadInLoop();
+        }
         // FIXME: close connection if n == 0
     }
     else if(n==0) {
         handleClose();
     }
     else{
+        if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+            stats_.addEagain();
+            loopStats_->addEagain();
+            if (serverStats_) serverStats_->addEagain();
+        }
         errno=savedErrno;
         LOG_SYSERR<<"TcpConnection::handleRead";
         handleError();
@@ -139,12 +568,16 @@ void TcpConnection::handleRead(Timestamp receiveTime)
 void TcpConnection::handleWrite()
 {
     loop_->assertInLoopThread();
-    if (channel_->isWriting()) {
-        ssize_t n = ::write(channel_->fd(),outputBuffer_.peek(),outputBuffer_.readableBytes());
-        if (n > 0) {
-            outputBuffer_.retrieve(n);
+    if (channel_.isWriting()) {
+        int savedErrno = 0;
+        ssize_t n = writeQueued(&savedErrno);
+        //sendfile遇到文件提前结束时返回0，该文件段已被丢弃
+        if (n >= 0) {
             if (outputBuffer_.readableBytes() == 0) {
-                channel_->disableWriting();
+                channel_.disableWriting();
+                if (writeCompleteCallback_) {
+                    loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+                }
                 if (state_ == kDisconnecting) {
                     shutdownInLoop();
                 }
@@ -154,6 +587,7 @@ void TcpConnection::handleWrite()
             }
         } 
         else {
+            errno = savedErrno;
             LOG_SYSERR << "TcpConnection::handleWrite";
         }
     } 
@@ -166,17 +600,32 @@ void TcpConnection::handleClose()
 {
     loop_->assertInLoopThread();
     LOG_TRACE << "TcpConnection::handleClose state = " << state_;
-    assert(state_ == kConnected|| state_ == kDisconnecting);
+    //forceClose()与对端关闭可能先后到达，只处理第一次
+    if (state_ == kDisconnected)
+    {
+        return;
+    }
+    setState(kDisconnected);
     // we don't close fd, leave it to dtor, so we can find leaks easily.
-    channel_->disableAll();
+    channel_.disableAll();
+
+    TcpConnectionPtr guardThis(shared_from_this());
+    connectionCallback_(guardThis);
     // must be the last line
-    closeCallback_(shared_from_this());
+    if (closeCallback_)
+    {
+        closeCallback_(guardThis);
+    }
 }
 
 void TcpConnection::handleError()
 {
-    int err = sockets::getSocketError(channel_->fd());
-    LOG_ERROR << "TcpConnection::handleError [" << name_
+    //MSG_ZEROCOPY的完成通知放在错误队列里，同样以POLLERR的形式到达
+    if (zeroCopy_ && outputBuffer_.handleZeroCopyCompletions(channel_.fd()) > 0) {
+        return;
+    }
+    int err = sockets::getSocketError(channel_.fd());
+    LOG_ERROR << "TcpConnection::handleError [" << name()
             << "] - SO_ERROR = " << err << " " ;
     //<< strerror_tl(err);
     //原代码中最后有strerror_tl(err) 一直编译不过，不知道是哪个头文件，待修复
@@ -4,42 +4,128 @@
 #include "Callbacks.h"
 #include "InetAddress.h"
 #include "../base/noncopyable.h"
+#include "../base/StringPiece.h"
 #include "Buffer.h"
+#include "BufferPool.h"
+#include "Channel.h"
+#include "OutputQueue.h"
+#include "Socket.h"
+#include "TimingWheel.h"
+#include "TrafficCounters.h"
 
 #include <boost/any.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
-#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <sys/types.h>
 
 namespace muduo
 {
 namespace net
 {
-class Channel;
 class EventLoop;
-class Socket;
 class TcpConnection : noncopyable,
                       public boost::enable_shared_from_this<TcpConnection>
 {
 public:
+    //连接名是namePrefix加上"#id"，只在需要时(比如打日志)才格式化
+    typedef boost::shared_ptr<const std::string> NamePrefixPtr;
+
     TcpConnection(EventLoop* loop,
-                const std::string& name,
+                uint64_t id,
+                const NamePrefixPtr& namePrefix,
                 int sockfd,
                 const InetAddress& localAddr,
                 const InetAddress& peerAddr);
     ~TcpConnection();
     EventLoop* getLoop() const { return loop_; }
-    const std::string& name() const { return name_; }
+    uint64_t id() const { return id_; }
+    std::string name() const;
     const InetAddress& localAddress() { return localAddr_; }
     const InetAddress& peerAddress() { return peerAddr_; }
     bool connected() const { return state_ == kConnected; }
 
-    //void send(const void* message, size_t len);
     // Thread safe.
+    // 在其他线程调用时，数据被拷贝一次放进PayloadPtr，之后转交给IO线程只是增加引用计数
+    void send(const void* message, size_t len);
+    void send(const StringPiece& message);
+    void send(const char* message);  // 避免字符串常量在StringPiece和string之间产生二义性
     void send(const std::string& message);
     // Thread safe.
+    // message被移动到PayloadPtr里，无论在哪个线程调用，未能立即写出的部分都不拷贝
+    void send(std::string&& message);
+    // Thread safe.
+    // 取走buf中的全部数据，调用后buf为空。输出队列为空时直接交换内部存储，不拷贝
+    void send(Buffer* buf);
+    // Thread safe.
+    // 只增加payload的引用计数，待发送的部分直接引用payload，不拷贝
+    void send(const PayloadPtr& payload);
+    // Thread safe.
+    // 发送文件fd中[offset, offset+length)的区间，可写时用sendfile()发送，
+    // 与send()的数据保持先后顺序。fd会被dup，调用方可以随即关闭自己的fd
+    void sendFile(int fd, off_t offset, size_t length);
+
+    // 不少于kZeroCopyThreshold字节的send()(任何重载)和队列的writev改用MSG_ZEROCOPY，
+    // 数据在内核通知完成(经错误队列，由handleError处理)之前一直保留。
+    // 应在loop线程调用，内核不支持时返回false
+    bool setZeroCopy(bool on);
+    static const size_t kZeroCopyThreshold = 64*1024;
+
+    // 开启后send()不再立即write，同一轮事件循环里的多次send()先放进输出队列，
+    // 在doPendingFunctors()中用一次writev发出去。应在loop线程调用
+    void setAutoCork(bool on);
+    // Thread safe.
     void shutdown();
+    // Thread safe.
+    // 不等输出队列发完，立即关闭连接并丢弃待发送的数据。
+    // abortive为true时设置SO_LINGER为0，close()发送RST而不是FIN
+    void forceClose(bool abortive = false);
+    // Thread safe.
+    // 先像shutdown()一样尝试发完数据再半关闭，若seconds秒后连接仍未断开
+    // (比如对端一直不读)，再forceClose(abortive)
+    void forceCloseWithDelay(double seconds, bool abortive = false);
+
+    // 本连接的流量统计，可在任意线程读取
+    const TrafficCounters& stats() const { return stats_; }
+    // 连接建立以来的秒数
+    double age() const;
+    // 除了本连接和所在EventLoop，再把流量累加到counters上，由TcpServer设置
+    void setAggregateCounters(TrafficCounters* counters) { serverStats_ = counters; }
+
+    // 由TimingWheel::add调用，之后每次读到数据都会刷新空闲计时
+    void setTimingWheel(TimingWheel* wheel, const boost::weak_ptr<TimingWheel::Entry>& entry)
+    { timingWheel_ = wheel; timingWheelEntry_ = entry; }
+
+    // return true if success.
+    bool getTcpInfo(struct tcp_info*) const;
+    //rtt、rttvar、cwnd、重传次数、未确认段数和发送队列字节数
+    std::string getTcpInfoString() const;
+
+    // 以下socket选项应在loop线程调用，通常在ConnectionCallback中
+    void setTcpNoDelay(bool on);
+    void setKeepAlive(bool on);
+    void setSocketOptions(const SocketOptions& options);
+
+    // Thread safe.
+    // 停止/恢复关注可读事件。停止期间数据留在内核的接收缓冲区里，
+    // 由TCP的流量控制把压力传回对端，而不是堆积在inputBuffer_中
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; } // NOT thread safe, may race with start/stopReadInLoop
+
+    // 每次messageCallback_返回后，inputBuffer_仍不少于bytes字节就自动stopRead()，
+    // 用户处理完积压的数据后调用startRead()恢复。0表示不限制
+    void setInputHighWaterMark(size_t bytes) { inputHighWaterMark_ = bytes; }
+
+    //用户保存在连接上的任意数据，比如协议解析的状态，只应在loop线程访问
+    void setContext(const boost::any& context)
+    { context_ = context; }
+    const boost::any& getContext() const
+    { return context_; }
+    boost::any* getMutableContext()
+    { return &context_; }
 
     void setConnectionCallback(const ConnectionCallback& cb)
     { connectionCallback_ = cb; }
@@ -49,6 +135,20 @@ public:
     //typedef boost::function<void (const TcpConnectionPtr&)> CloseCallback;
     void setCloseCallback(const CloseCallback& cb)
     { closeCallback_ = cb; }
+    /*
+    发送方可以在HighWaterMarkCallback中暂停生产数据，在WriteCompleteCallback中恢复，
+    避免对端读得慢时输出队列无限增长
+    */
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb)
+    { writeCompleteCallback_ = cb; }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+    { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
+    size_t highWaterMark() const { return highWaterMark_; }
+    // Not thread safe, 用于按连接统计内存
+    size_t pendingOutputBytes() const { return outputBuffer_.readableBytes(); }
+    size_t pendingInputBytes() const { return inputBuffer_.readableBytes(); }
+    // 只应在loop线程使用，比如在messageCallback_之外继续处理留在输入缓冲区里的数据
+    Buffer* inputBuffer() { return &inputBuffer_; }
     void connectEstablished();
     void connectDestroyed();  // should be called only once
 private:
@@ -60,21 +160,45 @@ private:
     void handleWrite();
     void handleClose();
     void handleError();
-    void sendInLoop(const std::string& message);
+    void sendInLoop(const void* data, size_t len);
+    void sendBufferInLoop(const boost::shared_ptr<Buffer>& buf);
+    void sendBufferInLoop(Buffer* buf);
+    void sendPayloadInLoop(const PayloadPtr& payload);
+    void sendFileInLoop(int fd, off_t offset, size_t length);
+    //输出队列为空时直接write，返回写出的字节数
+    size_t writeDirectly(const void* data, size_t len);
+    //把输出队列写到socket一次，并计入流量统计
+    ssize_t writeQueued(int* savedErrno);
+    void countWrite(ssize_t n, size_t len, int savedErrno);
+    //数据入队后调用，oldLen是入队前的长度：检查高水位并关注可写事件
+    void outputQueued(size_t oldLen);
+    //刚入队的数据之前没有待发送的内容时，立刻尝试发送一次
+    void flushQueuedInLoop(size_t oldLen);
+    //autoCork_时安排一次flushCorkedInLoop
+    void scheduleCorkedFlush();
+    void flushCorkedInLoop();
     void shutdownInLoop();
+    void forceCloseInLoop(bool abortive);
+    void startReadInLoop();
+    void stopReadInLoop();
 
     EventLoop* loop_;
-    std::string name_;
+    const uint64_t id_;
+    NamePrefixPtr namePrefix_;
     StateE state_;  // FIXME: use atomic variable
-    // we don't expose those classes to client.
+    bool zeroCopy_;
+    bool reading_;
+    bool autoCork_;
+    bool corkedFlushPending_;
     /*
-    socket_是一个Socket类指针，指向的Socket的socket的文件描述符便是与客户端通信的connfd
+    socket_的文件描述符便是与客户端通信的connfd
+    socket_和channel_直接作为成员，与TcpConnection在同一块内存里，不再单独分配
     */
-    boost::scoped_ptr<Socket> socket_;
+    Socket socket_;
     /*
     channel_的作用是，当建立连接时，将connfd与channel_绑定，然后将channel_加入到poller中，方便后续的通信
     */
-    boost::scoped_ptr<Channel> channel_;
+    Channel channel_;
     InetAddress localAddr_;
     InetAddress peerAddr_;
     /*
@@ -84,8 +208,21 @@ private:
     ConnectionCallback connectionCallback_;
     MessageCallback messageCallback_;
     CloseCallback closeCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    HighWaterMarkCallback highWaterMarkCallback_;
+    size_t highWaterMark_;
+    size_t inputHighWaterMark_;
+    const Timestamp created_;
+    TrafficCounters stats_;
+    TrafficCounters* loopStats_;
+    TrafficCounters* serverStats_;
+    TimingWheel* timingWheel_;
+    boost::weak_ptr<TimingWheel::Entry> timingWheelEntry_;
+    //两个缓冲区的存储从loop的pool中取，析构时还回去；持有pool的引用，连接可能比loop活得久
+    const boost::shared_ptr<BufferPool> bufferPool_;
     Buffer inputBuffer_;
-    Buffer outputBuffer_;
+    OutputQueue outputBuffer_;
+    boost::any context_;
 };
 }//net
 }//muduo
@@ -4,19 +4,31 @@
 #include "Acceptor.h"
 #include "EventLoop.h"
 #include "SocketsOps.h"
+#include "TimingWheel.h"
 
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 
-#include <stdio.h>  // snprintf
+#include <netinet/tcp.h>
 
 using namespace muduo;
 using namespace muduo::net;
-TcpServer::TcpServer(EventLoop* loop, const InetAddress& listenAddr)
+TcpServer::TcpServer(EventLoop* loop, const InetAddress& listenAddr,
+                     Option option)
   : loop_(loop),
     name_(listenAddr.toHostPort()),
-    acceptor_(new Acceptor(loop, listenAddr)),
+    namePrefix_(new std::string(name_)),
+    acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)),
+    highWaterMark_(64*1024*1024),
+    tcpInfoInterval_(0.0),
     started_(false),
-    nextConnId_(1)
+    nextConnId_(1),
+    maxConnections_(0),
+    maxConnectionsPerIp_(0),
+    acceptRate_(0.0),
+    acceptBurst_(0.0),
+    acceptTokens_(0.0),
+    rejectedConnections_(0)
 {
     /*
     _1和_2 这个叫做站位符，他代表这个位置有个参数，但现在还不知道参
@@ -27,12 +39,26 @@ TcpServer::TcpServer(EventLoop* loop, const InetAddress& listenAddr)
 }
 TcpServer::~TcpServer()
 {
+    //定时器回调绑定的是this，必须在析构前取消
+    if (tcpInfoCallback_ && tcpInfoInterval_ > 0.0 && started_)
+    {
+        loop_->cancel(tcpInfoTimer_);
+    }
 }
 void TcpServer::start()
 {
     if (!started_)
     {
         started_ = true;
+        if (tcpInfoCallback_ && tcpInfoInterval_ > 0.0)
+        {
+            tcpInfoTimer_ = loop_->runEvery(tcpInfoInterval_,
+                boost::bind(&TcpServer::sampleTcpInfo, this));
+        }
+        if (timingWheel_)
+        {
+            loop_->runInLoop(boost::bind(&TimingWheel::start, get_pointer(timingWheel_)));
+        }
     }
 
     if (!acceptor_->listenning())
@@ -41,23 +67,171 @@ void TcpServer::start()
         loop_->runInLoop(boost::bind(&Acceptor::listen, get_pointer(acceptor_)));
     }
 }
+void TcpServer::setIdleTimeout(int seconds)
+{
+    assert(!started_);
+    if (seconds > 0)
+    {
+        timingWheel_.reset(new TimingWheel(loop_, seconds));
+    }
+    else
+    {
+        timingWheel_.reset();
+    }
+}
+void TcpServer::setDeferAccept(int seconds)
+{
+    assert(!started_);
+    acceptor_->setDeferAccept(seconds);
+}
+void TcpServer::setFastOpen(int queueLength)
+{
+    assert(!started_);
+    acceptor_->setFastOpen(queueLength);
+}
+void TcpServer::setAcceptRateLimit(double rate, int burst)
+{
+    acceptRate_ = rate;
+    acceptBurst_ = burst > 0 ? burst : 1;
+    acceptTokens_ = acceptBurst_;
+    lastRefill_ = Timestamp::now();
+}
+TcpServer::PeerIp TcpServer::peerIp(const InetAddress& peerAddr)
+{
+    unsigned char bytes[16];
+    if (peerAddr.family() == AF_INET6)
+    {
+        const struct sockaddr_in6* addr6 =
+            reinterpret_cast<const struct sockaddr_in6*>(peerAddr.getSockAddr());
+        memcpy(bytes, &addr6->sin6_addr, sizeof bytes);
+    }
+    else
+    {
+        //::ffff:a.b.c.d
+        memZero(bytes, 10);
+        bytes[10] = 0xff;
+        bytes[11] = 0xff;
+        memcpy(bytes + 12, &peerAddr.getSockAddrInet().sin_addr, 4);
+    }
+    PeerIp ip;
+    memcpy(&ip.first, bytes, sizeof ip.first);
+    memcpy(&ip.second, bytes + 8, sizeof ip.second);
+    return ip;
+}
+/*
+依次检查令牌桶、总连接数和单个IP的连接数，任何一项超限都拒绝
+*/
+bool TcpServer::admit(const InetAddress& peerAddr)
+{
+    if (acceptRate_ > 0.0)
+    {
+        Timestamp now(Timestamp::now());
+        acceptTokens_ += timeDifference(now, lastRefill_) * acceptRate_;
+        if (acceptTokens_ > acceptBurst_)
+        {
+            acceptTokens_ = acceptBurst_;
+        }
+        lastRefill_ = now;
+        if (acceptTokens_ < 1.0)
+        {
+            LOG_WARN << "TcpServer::admit [" << name_ << "] - accept rate exceeded";
+            return false;
+        }
+    }
+    if (maxConnections_ > 0
+        && connections_.size() >= implicit_cast<size_t>(maxConnections_))
+    {
+        LOG_WARN << "TcpServer::admit [" << name_ << "] - too many connections "
+                 << connections_.size();
+        return false;
+    }
+    //Unix domain socket的对端没有IP，不按IP限制
+    if (maxConnectionsPerIp_ > 0 && !peerAddr.isUnix())
+    {
+        int& count = connectionsPerIp_[peerIp(peerAddr)];
+        if (count >= maxConnectionsPerIp_)
+        {
+            LOG_WARN << "TcpServer::admit [" << name_ << "] - too many connections from "
+                     << peerAddr.toHostPort();
+            return false;
+        }
+        ++count;
+    }
+    if (acceptRate_ > 0.0)
+    {
+        acceptTokens_ -= 1.0;
+    }
+    return true;
+}
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
     loop_->assertInLoopThread();
-    char buf[32];
-    snprintf(buf, sizeof buf, "#%d", nextConnId_);
-    ++nextConnId_;
-    std::string connName = name_ + buf;
+    if (!admit(peerAddr))
+    {
+        ++rejectedConnections_;
+        sockets::close(sockfd);
+        return;
+    }
+    uint64_t connId = nextConnId_++;
 
     LOG_INFO << "TcpServer::newConnection [" << name_
-           << "] - new connection [" << connName
+           << "] - new connection [" << name_ << "#" << connId
            << "] from " << peerAddr.toHostPort();
     InetAddress localAddr(sockets::getLocalAddr(sockfd));
     // FIXME poll with zero timeout to double confirm the new connection
-    TcpConnectionPtr conn(
-      new TcpConnection(loop_, connName, sockfd, localAddr, peerAddr));
-    connections_[connName] = conn;
+    // TcpConnection连同Socket、Channel和shared_ptr的控制块只占pool中的一块内存
+    TcpConnectionPtr conn(boost::allocate_shared<TcpConnection>(
+      PoolAllocator<TcpConnection>(loop_->connectionPool()),
+      loop_, connId, namePrefix_, sockfd, localAddr, peerAddr));
+    connections_[connId] = conn;
+    conn->setSocketOptions(connectionOptions_);
+    conn->setAggregateCounters(&trafficCounters_);
+    if (timingWheel_)
+    {
+        timingWheel_->add(conn);
+    }
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
+    conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setCloseCallback(
+      boost::bind(&TcpServer::removeConnection, this, _1));
+    if (highWaterMarkCallback_) {
+        conn->setHighWaterMarkCallback(highWaterMarkCallback_, highWaterMark_);
+    }
     conn->connectEstablished();
+}
+void TcpServer::removeConnection(const TcpConnectionPtr& conn)
+{
+    loop_->assertInLoopThread();
+    LOG_INFO << "TcpServer::removeConnection [" << name_
+           << "] - connection " << name_ << "#" << conn->id();
+    size_t n = connections_.erase(conn->id());
+    assert(n == 1); (void)n;
+    PeerCountMap::iterator it = connectionsPerIp_.empty() || conn->peerAddress().isUnix()
+        ? connectionsPerIp_.end()
+        : connectionsPerIp_.find(peerIp(conn->peerAddress()));
+    if (it != connectionsPerIp_.end() && --it->second <= 0)
+    {
+        connectionsPerIp_.erase(it);
+    }
+    loop_->queueInLoop(
+      boost::bind(&TcpConnection::connectDestroyed, conn));
+}
+/*
+在loop线程里遍历所有连接，逐个getsockopt(TCP_INFO)，
+取不到(比如连接正在关闭)的跳过
+*/
+void TcpServer::sampleTcpInfo()
+{
+    loop_->assertInLoopThread();
+    struct tcp_info tcpi;
+    for (ConnectionMap::iterator it = connections_.begin();
+         it != connections_.end(); ++it)
+    {
+        const TcpConnectionPtr& conn = it->second;
+        if (conn->connected() && conn->getTcpInfo(&tcpi))
+        {
+            tcpInfoCallback_(conn, tcpi);
+        }
+    }
 }
\ No newline at end of file
@@ -3,11 +3,12 @@
 
 #include "Callbacks.h"
 #include "TcpConnection.h"
+#include "Socket.h"
+#include "TimerId.h"
 #include "../base/noncopyable.h"
 
-#include <map>
-
 #include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 namespace muduo
 {
@@ -15,30 +16,107 @@ namespace net
 {
 class Acceptor;
 class EventLoop;
+class TimingWheel;
 
 class TcpServer : noncopyable
 {
 public:
-    TcpServer(EventLoop* loop, const InetAddress& listenAddr);
+    enum Option
+    {
+        kNoReusePort,
+        kReusePort,
+    };
+
+    TcpServer(EventLoop* loop, const InetAddress& listenAddr,
+              Option option = kNoReusePort);
     ~TcpServer(); 
     void start();
+
+    //每隔interval秒对所有连接采样一次TCP_INFO，交给cb导出，需要在start()之前设置
+    void setTcpInfoCallback(const TcpInfoCallback& cb, double interval)
+    { tcpInfoCallback_ = cb; tcpInfoInterval_ = interval; }
+
+    //连续seconds秒没有收到数据的连接会被关闭，需要在start()之前设置
+    void setIdleTimeout(int seconds);
+
+    /*
+    准入控制：超过限制的新连接在accept之后、创建TcpConnection之前就关闭，代价只有一次close()。
+    以下设置应在start()之前或loop线程中进行
+    */
+    //同时存在的连接数上限，0表示不限制
+    void setMaxConnections(int maxConnections)
+    { maxConnections_ = maxConnections; }
+    //同一个对端IP的连接数上限，0表示不限制
+    void setMaxConnectionsPerIp(int maxConnectionsPerIp)
+    { maxConnectionsPerIp_ = maxConnectionsPerIp; }
+    //令牌桶限制接受新连接的速率：每秒补充rate个令牌，最多积攒burst个，rate<=0表示不限制
+    void setAcceptRateLimit(double rate, int burst);
+    // Not thread safe
+    size_t numConnections() const { return connections_.size(); }
+    int64_t rejectedConnections() const { return rejectedConnections_; }
+
+    //本server所有连接的流量汇总，可在任意线程读取
+    const TrafficCounters& trafficCounters() const { return trafficCounters_; }
+
+    //每个新连接默认使用的socket选项，比如关闭Nagle算法
+    void setConnectionOptions(const SocketOptions& options)
+    { connectionOptions_ = options; }
+    //监听socket的选项，需要在start()之前设置
+    void setDeferAccept(int seconds);
+    void setFastOpen(int queueLength);
     
     void setConnectionCallback(const ConnectionCallback& cb)
     { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback& cb)
     { messageCallback_ = cb; }
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb)
+    { writeCompleteCallback_ = cb; }
+    //新连接默认使用的高水位回调
+    void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
+    { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
 private:
     void newConnection(int sockfd, const InetAddress& peerAddr);
-    typedef std::map<std::string, TcpConnectionPtr> ConnectionMap;
+    /*
+    把conn从ConnectionMap中移除
+    */
+    void removeConnection(const TcpConnectionPtr& conn);
+    void sampleTcpInfo();
+    //是否接受来自peerAddr的新连接
+    bool admit(const InetAddress& peerAddr);
+    //以连接id为键，接受和断开连接时不再需要拼接、比较字符串
+    typedef boost::unordered_map<uint64_t, TcpConnectionPtr> ConnectionMap;
+    //以对端IP的16字节二进制形式为键，IPv4按v4-mapped的IPv6地址存放，与IPv6共用；
+    //不必为每个连接格式化字符串
+    typedef std::pair<uint64_t, uint64_t> PeerIp;
+    typedef boost::unordered_map<PeerIp, int> PeerCountMap;
+    static PeerIp peerIp(const InetAddress& peerAddr);
     EventLoop* loop_;  // the acceptor loop
     const std::string name_;
+    const TcpConnection::NamePrefixPtr namePrefix_;  // 所有连接共享，同name_
 
     boost::scoped_ptr<Acceptor> acceptor_; // avoid revealing Acceptor
+    boost::scoped_ptr<TimingWheel> timingWheel_;
     ConnectionCallback connectionCallback_;
     MessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    HighWaterMarkCallback highWaterMarkCallback_;
+    size_t highWaterMark_;
+    SocketOptions connectionOptions_;
+    TcpInfoCallback tcpInfoCallback_;
+    double tcpInfoInterval_;
+    TimerId tcpInfoTimer_;
     bool started_;
-    int nextConnId_;  // always in loop thread
+    uint64_t nextConnId_;  // always in loop thread
     ConnectionMap connections_;
+    TrafficCounters trafficCounters_;
+    int maxConnections_;
+    int maxConnectionsPerIp_;
+    PeerCountMap connectionsPerIp_;  // 只在限制每个IP时维护
+    double acceptRate_;
+    double acceptBurst_;
+    double acceptTokens_;
+    Timestamp lastRefill_;
+    int64_t rejectedConnections_;
 };
 
 }//net
@@ -1,6 +1,8 @@
 #include "Timer.h"
 using namespace muduo;
 using namespace muduo::net;
+
+AtomicInt64 Timer::s_numCreated_;
 void Timer::restart(Timestamp now){
     if(repeat_){
         expiration_=addTime(now,interval_);
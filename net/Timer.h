@@ -19,7 +19,8 @@ public:
     :callback_(cb),
     expiration_(when),
     interval_(interval),
-    repeat_(interval>0.0)
+    repeat_(interval>0.0),
+    sequence_(s_numCreated_.incrementAndGet())
     { 
     }
     void run() const {
@@ -27,6 +28,7 @@ public:
     }
     Timestamp expiration() const { return expiration_; }
     bool repeat() const { return repeat_; }
+    int64_t sequence() const { return sequence_; }
     /* 重新计算超时时间 */
     void restart(Timestamp now);
     
@@ -35,6 +37,10 @@ private:
     Timestamp expiration_;
     const double interval_;
     const bool repeat_;
+    //全局唯一的序号，与地址一起标识一个Timer，地址被重用时也不会认错
+    const int64_t sequence_;
+
+    static AtomicInt64 s_numCreated_;
 };
 }//net
 }//muduo
@@ -6,21 +6,36 @@
 
 #include "../base/copyable.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
 namespace muduo
 {
 namespace net
 {
 
 class Timer;
+///
+/// An opaque identifier, for canceling Timer.
+///
 class TimerId : public copyable{
 public:
-    explicit TimerId(Timer* timer)
-    : value_(timer)
+    TimerId()
+    : timer_(NULL),
+      sequence_(0)
+    {
+    }
+    TimerId(Timer* timer, int64_t seq)
+    : timer_(timer),
+      sequence_(seq)
     {
     }
 
+    friend class TimerQueue;
+
 private:
-    Timer* value_;
+    Timer* timer_;
+    int64_t sequence_;
 };
 
 }//net
@@ -103,7 +103,8 @@ TimerQueue::TimerQueue(EventLoop* loop)
     :loop_(loop),
     timerfd_(createTimerfd()),
     timerfdChannel_(loop,timerfd_),
-    timers_()
+    timers_(),
+    callingExpiredTimers_(false)
 {
     timerfdChannel_.setReadCallback(boost::bind(&TimerQueue::handleRead,this));
     timerfdChannel_.enableReading();
@@ -128,7 +129,10 @@ TimerQueue::~TimerQueue(){
 TimerId TimerQueue::addTimer(const TimerCallback& cb,Timestamp when,double interval){
     Timer* timer=new Timer(std::move(cb),when,interval);
     loop_->runInLoop(boost::bind(&TimerQueue::addTimerInLoop,this,timer));
-    return TimerId(timer);
+    return TimerId(timer,timer->sequence());
+}
+void TimerQueue::cancel(TimerId timerId){
+    loop_->runInLoop(boost::bind(&TimerQueue::cancelInLoop,this,timerId));
 }
 //完成修改定时器列表的工作
 void TimerQueue::addTimerInLoop(Timer* timer){
@@ -139,6 +143,26 @@ void TimerQueue::addTimerInLoop(Timer* timer){
     }
 }
 /*
+不在timers_中的有两种情况：已经到期删除了，什么也不做；
+或者是正在执行回调的周期任务，记下来让reset()不再把它加回去
+*/
+void TimerQueue::cancelInLoop(TimerId timerId){
+    loop_->assertInLoopThread();
+    assert(timers_.size()==activeTimers_.size());
+    ActiveTimer timer(timerId.timer_,timerId.sequence_);
+    ActiveTimerSet::iterator it=activeTimers_.find(timer);
+    if(it!=activeTimers_.end()){
+        size_t n=timers_.erase(Entry(it->first->expiration(),it->first));
+        assert(n==1); (void)n;
+        delete it->first;
+        activeTimers_.erase(it);
+    }
+    else if(callingExpiredTimers_){
+        cancelingTimers_.insert(timer);
+    }
+    assert(timers_.size()==activeTimers_.size());
+}
+/*
 当定时器超时，保存timerfd的Channel激活，调用回调函数
 */
 void TimerQueue::handleRead(){
@@ -146,9 +170,12 @@ void TimerQueue::handleRead(){
     Timestamp now(Timestamp::now());
     readTimerfd(timerfd_,now);
     std::vector<Entry>expired=getExpired(now) ;
+    callingExpiredTimers_=true;
+    cancelingTimers_.clear();
     for(std::vector<Entry>::iterator it=expired.begin();it!=expired.end();++it){
         it->second->run();
     }
+    callingExpiredTimers_=false;
     reset(expired,now);
 }
 /*
@@ -173,14 +200,20 @@ std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now){
     */
     std::copy(timers_.begin(),it,back_inserter(expired));
     timers_.erase(timers_.begin(),it);
+    for(std::vector<Entry>::iterator e=expired.begin();e!=expired.end();++e){
+        size_t n=activeTimers_.erase(ActiveTimer(e->second,e->second->sequence()));
+        assert(n==1); (void)n;
+    }
     return expired;
 }
 //调用完回调函数之后需要将周期性任务重新添加到set中，要重新计算超时时间
 void TimerQueue::reset(const std::vector<Entry>& expired,Timestamp now){
     Timestamp nextExpire;
     for(std::vector<Entry>::const_iterator it=expired.begin();it!=expired.end();++it){
-        //是否为周期性任务
-        if(it->second->repeat()){
+        //是否为周期性任务，回调执行期间被取消的不再加回去
+        ActiveTimer timer(it->second,it->second->sequence());
+        if(it->second->repeat()
+           && cancelingTimers_.find(timer)==cancelingTimers_.end()){
 
             it->second->restart(now);
             insert(it->second);
@@ -217,5 +250,9 @@ bool TimerQueue::insert(Timer* timer){
     如果等值元素已经存在（即无新元素插入），则返回 false。　
     */
     std::pair<TimerList::iterator,bool>result=timers_.insert(std::make_pair(when,timer));
+    assert(result.second); (void)result;
+    std::pair<ActiveTimerSet::iterator,bool>active=
+        activeTimers_.insert(ActiveTimer(timer,timer->sequence()));
+    assert(active.second); (void)active;
     return earliestChanged;
 }
\ No newline at end of file
@@ -29,10 +29,19 @@ public:
    * @interval，是否是周期性超时任务
    */
     TimerId addTimer(const TimerCallback& cb,Timestamp when,double interval);
+    /*
+    取消定时任务，已经到期或者已经取消的timerId什么也不做。
+    在loop线程调用时立即生效，之后回调一定不会再执行
+    */
+    void cancel(TimerId timerId);
 private:
     typedef std::pair<Timestamp, Timer*> Entry;
     typedef std::set<Entry> TimerList;
+    //与timers_保存同样的Timer，按地址和序号排序，用于按TimerId查找
+    typedef std::pair<Timer*, int64_t> ActiveTimer;
+    typedef std::set<ActiveTimer> ActiveTimerSet;
     void addTimerInLoop(Timer* timer);
+    void cancelInLoop(TimerId timerId);
     /*
     当定时器超时，保存timerfd的Channel激活，调用回调函数
     */
@@ -53,6 +62,10 @@ private:
     Channel timerfdChannel_;
     /* 保存所有的定时任务 */
     TimerList timers_;
+    ActiveTimerSet activeTimers_;
+    /* 正在执行到期的回调，回调里取消的周期任务记在cancelingTimers_中，不再重新加入 */
+    bool callingExpiredTimers_;
+    ActiveTimerSet cancelingTimers_;
 
 };
 
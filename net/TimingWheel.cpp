@@ -0,0 +1,74 @@
+#include "TimingWheel.h"
+
+#include "../base/Logging.h"
+#include "EventLoop.h"
+#include "TcpConnection.h"
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+TimingWheel::Entry::~Entry()
+{
+    TcpConnectionPtr conn = weakConn_.lock();
+    if (conn)
+    {
+        //时间轮析构时也会走到这里，而forceClose()是排队执行的，
+        //在那之前连接可能还会读到数据，不能让它再touch()已经析构的时间轮
+        conn->setTimingWheel(NULL, WeakEntryPtr());
+        LOG_INFO << "TimingWheel - connection " << conn->name()
+                 << " idle timeout";
+        //空闲的对端多半已经失联，半关闭等不到它的FIN
+        conn->forceClose();
+    }
+}
+
+TimingWheel::TimingWheel(EventLoop* loop, int idleSeconds)
+  : loop_(loop),
+    buckets_(idleSeconds),
+    tick_(0)
+{
+    assert(idleSeconds > 0);
+    buckets_.resize(idleSeconds);
+}
+
+TimingWheel::~TimingWheel()
+{
+    //没有start()过时timer_是默认值，cancel什么也不做
+    loop_->cancel(timer_);
+}
+
+void TimingWheel::start()
+{
+    loop_->assertInLoopThread();
+    timer_ = loop_->runEvery(1.0, boost::bind(&TimingWheel::onTimer, this));
+}
+
+void TimingWheel::add(const TcpConnectionPtr& conn)
+{
+    loop_->assertInLoopThread();
+    EntryPtr entry(new Entry(conn));
+    entry->lastTick_ = tick_;
+    buckets_.back().insert(entry);
+    conn->setTimingWheel(this, WeakEntryPtr(entry));
+}
+
+void TimingWheel::touch(const WeakEntryPtr& weakEntry)
+{
+    loop_->assertInLoopThread();
+    EntryPtr entry(weakEntry.lock());
+    if (entry && entry->lastTick_ != tick_)
+    {
+        entry->lastTick_ = tick_;
+        buckets_.back().insert(entry);
+    }
+}
+/*
+push_back一个空格子会挤掉最老的格子，其中引用计数降为0的Entry随之析构
+*/
+void TimingWheel::onTimer()
+{
+    ++tick_;
+    buckets_.push_back(Bucket());
+}
@@ -0,0 +1,79 @@
+/*
+空闲连接的时间轮
+*/
+#ifndef MUDUO_NET_TIMINGWHEEL_H
+#define MUDUO_NET_TIMINGWHEEL_H
+
+#include "../base/noncopyable.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+
+#include <boost/circular_buffer.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Closes connections that have no incoming traffic for idleSeconds.
+///
+/*
+整个EventLoop只用一个每秒触发的定时器，而不是每个连接一个TimerQueue定时器。
+时间轮有idleSeconds个格子，每个格子是一组Entry的shared_ptr。
+连接有数据到达时把它的Entry放进最新的格子，每秒丢弃最老的一个格子；
+当一个Entry不再被任何格子引用时析构，这时连接已经空闲了idleSeconds秒，在析构函数中关闭它。
+Entry只持有连接的weak_ptr，所以不会延长连接的生命期
+*/
+class TimingWheel : noncopyable
+{
+public:
+    typedef boost::weak_ptr<TcpConnection> WeakTcpConnectionPtr;
+
+    struct Entry : noncopyable
+    {
+        explicit Entry(const WeakTcpConnectionPtr& weakConn)
+          : weakConn_(weakConn), lastTick_(0)
+        { }
+        ~Entry();
+
+        WeakTcpConnectionPtr weakConn_;
+        uint64_t lastTick_;  // 最近一次放进的格子，同一秒内重复刷新时直接跳过
+    };
+    typedef boost::shared_ptr<Entry> EntryPtr;
+    typedef boost::weak_ptr<Entry> WeakEntryPtr;
+
+    TimingWheel(EventLoop* loop, int idleSeconds);
+    ~TimingWheel();
+
+    //开始每秒转动一格，must be called in loop thread
+    void start();
+    //新连接加入时间轮，并把自己登记到连接上
+    void add(const TcpConnectionPtr& conn);
+    //连接有数据到达，由TcpConnection::handleRead调用
+    void touch(const WeakEntryPtr& weakEntry);
+
+    int idleSeconds() const { return static_cast<int>(buckets_.capacity()); }
+
+private:
+    typedef boost::unordered_set<EntryPtr> Bucket;
+    typedef boost::circular_buffer<Bucket> BucketList;
+
+    void onTimer();
+
+    EventLoop* loop_;
+    BucketList buckets_;
+    uint64_t tick_;  // 已经转过的格数
+    TimerId timer_;
+};
+
+}//net
+}//muduo
+#endif
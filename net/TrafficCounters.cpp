@@ -0,0 +1,25 @@
+#include "TrafficCounters.h"
+
+#include <inttypes.h>
+#include <stdio.h>  // snprintf
+
+using namespace muduo;
+using namespace muduo::net;
+
+std::string TrafficCounters::toString() const
+{
+    char buf[256];
+    snprintf(buf, sizeof buf,
+             "read=%" PRId64 "B/%" PRId64 " write=%" PRId64 "B/%" PRId64
+             " partial=%" PRId64 " eagain=%" PRId64
+             " peak_in=%" PRId64 " peak_out=%" PRId64,
+             bytesRead.load(std::memory_order_relaxed),
+             readCalls.load(std::memory_order_relaxed),
+             bytesWritten.load(std::memory_order_relaxed),
+             writeCalls.load(std::memory_order_relaxed),
+             partialWrites.load(std::memory_order_relaxed),
+             eagainCount.load(std::memory_order_relaxed),
+             peakInputBytes.load(std::memory_order_relaxed),
+             peakOutputBytes.load(std::memory_order_relaxed));
+    return buf;
+}
@@ -0,0 +1,83 @@
+/*
+连接的流量统计，同一个结构也用来按EventLoop和TcpServer汇总
+*/
+#ifndef MUDUO_NET_TRAFFICCOUNTERS_H
+#define MUDUO_NET_TRAFFICCOUNTERS_H
+
+#include "../base/noncopyable.h"
+
+#include <atomic>
+#include <string>
+
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Always-on traffic counters.
+///
+/*
+所有计数都用memory_order_relaxed，只保证单个计数不丢，不保证计数之间的先后关系，
+所以在IO线程里累加的开销很小，其他线程随时可以读，读到的是近似的快照
+*/
+struct TrafficCounters : noncopyable
+{
+    TrafficCounters()
+      : bytesRead(0),
+        bytesWritten(0),
+        readCalls(0),
+        writeCalls(0),
+        partialWrites(0),
+        eagainCount(0),
+        peakInputBytes(0),
+        peakOutputBytes(0)
+    { }
+
+    void addRead(int64_t bytes)
+    {
+        readCalls.fetch_add(1, std::memory_order_relaxed);
+        bytesRead.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    //partial表示这次没能把要写的数据全部写完
+    void addWrite(int64_t bytes, bool partial)
+    {
+        writeCalls.fetch_add(1, std::memory_order_relaxed);
+        bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+        if (partial)
+            partialWrites.fetch_add(1, std::memory_order_relaxed);
+    }
+    void addEagain()
+    { eagainCount.fetch_add(1, std::memory_order_relaxed); }
+
+    void updatePeakInput(int64_t bytes) { updatePeak(&peakInputBytes, bytes); }
+    void updatePeakOutput(int64_t bytes) { updatePeak(&peakOutputBytes, bytes); }
+
+    std::string toString() const;
+
+    std::atomic<int64_t> bytesRead;
+    std::atomic<int64_t> bytesWritten;
+    std::atomic<int64_t> readCalls;
+    std::atomic<int64_t> writeCalls;
+    std::atomic<int64_t> partialWrites;
+    std::atomic<int64_t> eagainCount;
+    std::atomic<int64_t> peakInputBytes;
+    std::atomic<int64_t> peakOutputBytes;
+
+private:
+    //汇总的计数可能被多个IO线程同时更新，用CAS保证取到最大值
+    static void updatePeak(std::atomic<int64_t>* peak, int64_t bytes)
+    {
+        int64_t old = peak->load(std::memory_order_relaxed);
+        while (bytes > old
+               && !peak->compare_exchange_weak(old, bytes, std::memory_order_relaxed))
+        {
+        }
+    }
+};
+
+}//net
+}//muduo
+#endif
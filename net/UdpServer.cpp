@@ -0,0 +1,41 @@
+#include "UdpServer.h"
+
+#include "../base/Logging.h"
+#include "EventLoop.h"
+
+#include <boost/bind.hpp>
+
+using namespace muduo;
+using namespace muduo::net;
+
+UdpServer::UdpServer(EventLoop* loop, const InetAddress& listenAddr,
+                     const std::string& name, Option option)
+  : loop_(loop),
+    name_(name),
+    socket_(loop, listenAddr.family()),
+    started_(false)
+{
+    //SO_REUSEPORT必须在bind之前设置
+    socket_.setReusePort(option == kReusePort);
+    socket_.bindAddress(listenAddr);
+    LOG_INFO << "UdpServer::UdpServer [" << name_ << "] - listening on "
+             << listenAddr.toHostPort();
+}
+
+UdpServer::~UdpServer()
+{
+}
+
+void UdpServer::start()
+{
+    if (!started_)
+    {
+        started_ = true;
+        loop_->runInLoop(boost::bind(&UdpServer::startInLoop, this));
+    }
+}
+
+void UdpServer::startInLoop()
+{
+    socket_.start();
+}
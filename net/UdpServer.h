@@ -0,0 +1,69 @@
+/*
+UdpServer在一个EventLoop上监听一个UDP端口
+*/
+#ifndef MUDUO_NET_UDPSERVER_H
+#define MUDUO_NET_UDPSERVER_H
+
+#include "../base/noncopyable.h"
+#include "UdpSocket.h"
+
+#include <string>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// UDP server bound to one EventLoop.
+///
+/*
+要用多个IO线程接收同一个端口，就在每个EventLoop上各建一个kReusePort的UdpServer，
+内核按四元组的哈希把数据报分到各个socket上
+*/
+class UdpServer : noncopyable
+{
+public:
+    enum Option
+    {
+        kNoReusePort,
+        kReusePort,
+    };
+
+    UdpServer(EventLoop* loop, const InetAddress& listenAddr,
+              const std::string& name, Option option = kNoReusePort);
+    ~UdpServer();
+
+    const std::string& name() const { return name_; }
+    EventLoop* getLoop() const { return loop_; }
+
+    //以下设置需要在start()之前进行
+    void setBatchSize(int batchSize) { socket_.setBatchSize(batchSize); }
+    void setMaxDatagramSize(size_t size) { socket_.setMaxDatagramSize(size); }
+    void setRecvBufferSize(int bytes) { socket_.setRecvBufferSize(bytes); }
+    void setMessageCallback(const UdpSocket::UdpMessageCallback& cb)
+    { socket_.setMessageCallback(cb); }
+
+    /// Starts the server if it's not listenning.
+    /// It's harmless to call it multiple times.
+    /// Thread safe.
+    void start();
+
+    //回复用这个socket发送，源地址就是监听的地址
+    UdpSocket* socket() { return &socket_; }
+    const UdpMetrics& metrics() const { return socket_.metrics(); }
+
+private:
+    void startInLoop();
+
+    EventLoop* loop_;
+    const std::string name_;
+    UdpSocket socket_;
+    bool started_;
+};
+
+}//net
+}//muduo
+#endif
@@ -0,0 +1,320 @@
+#include "UdpSocket.h"
+
+#include "../base/Logging.h"
+#include "EventLoop.h"
+#include "SocketsOps.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <stdio.h>  // snprintf
+#include <string.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103  // since Linux 4.18
+#endif
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+const int kDefaultBatchSize = 64;
+const size_t kDefaultMaxDatagramSize = 2048;
+const size_t kDefaultMaxSendQueue = 64*1024;
+//每个数据报一份，放UDP_SEGMENT
+const size_t kControlSize = CMSG_SPACE(sizeof(uint16_t));
+}
+
+std::string UdpMetrics::toString() const
+{
+    char buf[256];
+    snprintf(buf, sizeof buf,
+             "batch=%" PRId64 " recv=%" PRId64 "/%" PRId64 "B/%" PRId64
+             " truncated=%" PRId64 " send=%" PRId64 "/%" PRId64 "B/%" PRId64
+             " drops=%" PRId64,
+             batchSize.load(std::memory_order_relaxed),
+             datagramsReceived.load(std::memory_order_relaxed),
+             bytesReceived.load(std::memory_order_relaxed),
+             recvCalls.load(std::memory_order_relaxed),
+             truncated.load(std::memory_order_relaxed),
+             datagramsSent.load(std::memory_order_relaxed),
+             bytesSent.load(std::memory_order_relaxed),
+             sendCalls.load(std::memory_order_relaxed),
+             sendDrops.load(std::memory_order_relaxed));
+    return buf;
+}
+
+UdpSocket::UdpSocket(EventLoop* loop, sa_family_t family)
+  : loop_(loop),
+    socket_(sockets::createUdpNonblockingOrDie(family)),
+    channel_(loop, socket_.fd()),
+    batchSize_(kDefaultBatchSize),
+    maxDatagramSize_(kDefaultMaxDatagramSize),
+    maxSendQueue_(kDefaultMaxSendQueue),
+    started_(false),
+    flushPending_(false),
+    self_(new UdpSocket*(this))
+{
+    channel_.setReadCallback(boost::bind(&UdpSocket::handleRead, this, _1));
+    channel_.setWriteCallback(boost::bind(&UdpSocket::handleWrite, this));
+    metrics_.batchSize.store(batchSize_, std::memory_order_relaxed);
+}
+
+UdpSocket::~UdpSocket()
+{
+    stop();
+}
+
+void UdpSocket::bindAddress(const InetAddress& localAddr)
+{
+    socket_.bindAddress(localAddr);
+}
+
+void UdpSocket::setBatchSize(int batchSize)
+{
+    assert(!started_);
+    assert(batchSize > 0);
+    batchSize_ = batchSize;
+    metrics_.batchSize.store(batchSize_, std::memory_order_relaxed);
+}
+
+void UdpSocket::setMaxDatagramSize(size_t size)
+{
+    assert(!started_);
+    maxDatagramSize_ = size;
+}
+/*
+recvMsgs_[i]固定指向第i个缓冲区和第i个地址，之后每次recvmmsg只需要重置长度
+*/
+void UdpSocket::allocateBuffers()
+{
+    recvBuffer_.resize(batchSize_ * maxDatagramSize_);
+    recvMsgs_.resize(batchSize_);
+    recvIovecs_.resize(batchSize_);
+    recvAddrs_.resize(batchSize_);
+    memZero(&recvMsgs_[0], recvMsgs_.size() * sizeof recvMsgs_[0]);
+    for (int i = 0; i < batchSize_; ++i)
+    {
+        recvIovecs_[i].iov_base = &recvBuffer_[i * maxDatagramSize_];
+        recvIovecs_[i].iov_len = maxDatagramSize_;
+        recvMsgs_[i].msg_hdr.msg_iov = &recvIovecs_[i];
+        recvMsgs_[i].msg_hdr.msg_iovlen = 1;
+        recvMsgs_[i].msg_hdr.msg_name = &recvAddrs_[i];
+    }
+    sendMsgs_.resize(batchSize_);
+    sendIovecs_.resize(batchSize_);
+    sendControl_.resize(batchSize_ * kControlSize);
+}
+
+void UdpSocket::start()
+{
+    loop_->assertInLoopThread();
+    assert(!started_);
+    started_ = true;
+    allocateBuffers();
+    channel_.enableReading();
+}
+
+//只发送不接收时channel_也可能因为关注可写而加入了Poller
+void UdpSocket::stop()
+{
+    loop_->assertInLoopThread();
+    started_ = false;
+    if (channel_.index() >= 0)
+    {
+        channel_.disableAll();
+        loop_->removeChannel(&channel_);
+    }
+}
+/*
+每次可读只调用一次recvmmsg，poll是水平触发的，没收完的下一轮还会通知，
+这样一个很忙的UDP socket不会饿死同一loop上的其他连接
+*/
+void UdpSocket::handleRead(Timestamp receiveTime)
+{
+    loop_->assertInLoopThread();
+    for (int i = 0; i < batchSize_; ++i)
+    {
+        recvMsgs_[i].msg_hdr.msg_namelen = sizeof recvAddrs_[i];
+        recvMsgs_[i].msg_hdr.msg_flags = 0;
+        recvMsgs_[i].msg_len = 0;
+    }
+    int n = ::recvmmsg(socket_.fd(), &recvMsgs_[0], batchSize_, MSG_DONTWAIT, NULL);
+    if (n < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            LOG_SYSERR << "UdpSocket::handleRead";
+        }
+        return;
+    }
+    metrics_.recvCalls.fetch_add(1, std::memory_order_relaxed);
+    metrics_.datagramsReceived.fetch_add(n, std::memory_order_relaxed);
+    int64_t bytes = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        const struct mmsghdr& msg = recvMsgs_[i];
+        bytes += msg.msg_len;
+        if (msg.msg_hdr.msg_flags & MSG_TRUNC)
+        {
+            metrics_.truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (messageCallback_)
+        {
+            InetAddress peer(recvAddrs_[i], msg.msg_hdr.msg_namelen);
+            messageCallback_(StringPiece(static_cast<const char*>(recvIovecs_[i].iov_base),
+                                         static_cast<int>(msg.msg_len)),
+                             peer, receiveTime);
+        }
+    }
+    metrics_.bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void UdpSocket::send(const InetAddress& peer, const StringPiece& data)
+{
+    sendSegmented(peer, data, 0);
+}
+
+void UdpSocket::sendSegmented(const InetAddress& peer, const StringPiece& data, uint16_t segmentSize)
+{
+    if (loop_->isInLoopThread())
+    {
+        enqueue(peer, data.data(), data.size(), segmentSize);
+    }
+    else
+    {
+        loop_->runInLoop(
+            boost::bind(&UdpSocket::sendIfAlive, WeakSelfPtr(self_), peer, data.as_string(), segmentSize));
+    }
+}
+/*
+析构和回调都在loop线程，lock()成功时socket一定还活着
+*/
+void UdpSocket::sendIfAlive(const WeakSelfPtr& weakSelf, const InetAddress& peer,
+                            const std::string& data, uint16_t segmentSize)
+{
+    SelfPtr self(weakSelf.lock());
+    if (self)
+    {
+        (*self)->enqueue(peer, data.data(), data.size(), segmentSize);
+    }
+}
+
+void UdpSocket::flushIfAlive(const WeakSelfPtr& weakSelf)
+{
+    SelfPtr self(weakSelf.lock());
+    if (self)
+    {
+        (*self)->flushInLoop();
+    }
+}
+/*
+同一轮事件循环里的多个数据报攒在一起，由flushInLoop用sendmmsg一次发出
+*/
+void UdpSocket::enqueue(const InetAddress& peer, const char* data, size_t len, uint16_t segmentSize)
+{
+    loop_->assertInLoopThread();
+    if (sendQueue_.size() >= maxSendQueue_)
+    {
+        metrics_.sendDrops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    sendQueue_.push_back(Datagram(peer, segmentSize));
+    sendQueue_.back().data.assign(data, len);
+    if (!flushPending_ && !channel_.isWriting())
+    {
+        flushPending_ = true;
+        loop_->queueInLoop(boost::bind(&UdpSocket::flushIfAlive, WeakSelfPtr(self_)));
+    }
+}
+
+void UdpSocket::flushInLoop()
+{
+    loop_->assertInLoopThread();
+    flushPending_ = false;
+    if (!started_ && sendMsgs_.empty())
+    {
+        //还没有start()，只发送不接收时也需要发送用的数组
+        allocateBuffers();
+    }
+    handleWrite();
+}
+/*
+一直发到队列为空或内核缓冲区满，满了就等可写事件
+*/
+void UdpSocket::handleWrite()
+{
+    loop_->assertInLoopThread();
+    while (!sendQueue_.empty())
+    {
+        int n = sendBatch();
+        if (n <= 0)
+        {
+            if (n == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (!channel_.isWriting())
+                    channel_.enableWriting();
+                return;
+            }
+            //目的地址不可达等错误只影响队首这个数据报，丢弃它继续发
+            LOG_SYSERR << "UdpSocket::handleWrite - to "
+                       << sendQueue_.front().peer.toHostPort();
+            metrics_.sendDrops.fetch_add(1, std::memory_order_relaxed);
+            sendQueue_.pop_front();
+        }
+    }
+    if (channel_.isWriting())
+    {
+        channel_.disableWriting();
+    }
+}
+
+int UdpSocket::sendBatch()
+{
+    const int count = static_cast<int>(std::min(sendQueue_.size(),
+                                                static_cast<size_t>(batchSize_)));
+    memZero(&sendMsgs_[0], count * sizeof sendMsgs_[0]);
+    for (int i = 0; i < count; ++i)
+    {
+        const Datagram& dgram = sendQueue_[i];
+        struct msghdr& hdr = sendMsgs_[i].msg_hdr;
+        sendIovecs_[i].iov_base = const_cast<char*>(dgram.data.data());
+        sendIovecs_[i].iov_len = dgram.data.size();
+        hdr.msg_iov = &sendIovecs_[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_name = const_cast<struct sockaddr*>(dgram.peer.getSockAddr());
+        hdr.msg_namelen = dgram.peer.getSockLen();
+        if (dgram.segmentSize > 0 && dgram.data.size() > dgram.segmentSize)
+        {
+            char* control = &sendControl_[i * kControlSize];
+            memZero(control, kControlSize);
+            hdr.msg_control = control;
+            hdr.msg_controllen = kControlSize;
+            struct cmsghdr* cm = CMSG_FIRSTHDR(&hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            memcpy(CMSG_DATA(cm), &dgram.segmentSize, sizeof dgram.segmentSize);
+        }
+    }
+    int n = ::sendmmsg(socket_.fd(), &sendMsgs_[0], count, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n > 0)
+    {
+        int64_t bytes = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            bytes += sendQueue_.front().data.size();
+            sendQueue_.pop_front();
+        }
+        metrics_.sendCalls.fetch_add(1, std::memory_order_relaxed);
+        metrics_.datagramsSent.fetch_add(n, std::memory_order_relaxed);
+        metrics_.bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    return n;
+}
@@ -0,0 +1,179 @@
+/*
+基于Channel的UDP socket，用recvmmsg/sendmmsg批量收发
+*/
+#ifndef MUDUO_NET_UDPSOCKET_H
+#define MUDUO_NET_UDPSOCKET_H
+
+#include "../base/noncopyable.h"
+#include "../base/StringPiece.h"
+#include "../base/Timestamp.h"
+#include "Channel.h"
+#include "InetAddress.h"
+#include "Socket.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Always-on UDP counters, safe to read from other threads.
+///
+//与TrafficCounters一样只用relaxed的原子操作；datagramsReceived/recvCalls就是平均每批收到的个数
+struct UdpMetrics : noncopyable
+{
+    UdpMetrics()
+      : batchSize(0),
+        datagramsReceived(0),
+        bytesReceived(0),
+        recvCalls(0),
+        truncated(0),
+        datagramsSent(0),
+        bytesSent(0),
+        sendCalls(0),
+        sendDrops(0)
+    { }
+
+    std::string toString() const;
+
+    std::atomic<int64_t> batchSize;  // 配置的每批最多个数
+    std::atomic<int64_t> datagramsReceived;
+    std::atomic<int64_t> bytesReceived;
+    std::atomic<int64_t> recvCalls;
+    std::atomic<int64_t> truncated;  // 超过maxDatagramSize被截断的
+    std::atomic<int64_t> datagramsSent;
+    std::atomic<int64_t> bytesSent;
+    std::atomic<int64_t> sendCalls;
+    std::atomic<int64_t> sendDrops;  // 发送队列满或发送出错而丢弃的
+};
+
+///
+/// Non-blocking UDP socket on an EventLoop.
+///
+/*
+接收：可读时调用一次recvmmsg()，一次最多收batchSize个数据报，
+放进预先分配好的batchSize个定长缓冲区，对每个数据报调用一次UdpMessageCallback。
+回调里的data直接指向这些缓冲区，只在回调期间有效。
+发送：send()只把数据报放进发送队列，在本轮事件循环结束时(doPendingFunctors)用sendmmsg()
+一次发出最多batchSize个；内核发送缓冲区满时关注可写事件，队列超过上限时丢弃新的数据报。
+segmentSize大于0时，一个大的缓冲区带上UDP_SEGMENT由内核(或网卡)切成多个数据报(GSO)，
+需要Linux 4.18以上
+*/
+class UdpSocket : noncopyable
+{
+public:
+    typedef boost::function<void (const StringPiece& data,
+                                  const InetAddress& peer,
+                                  Timestamp receiveTime)> UdpMessageCallback;
+
+    UdpSocket(EventLoop* loop, sa_family_t family);
+    ~UdpSocket();
+
+    EventLoop* getLoop() const { return loop_; }
+    int fd() const { return socket_.fd(); }
+
+    /// abort if address in use
+    void bindAddress(const InetAddress& localAddr);
+    //多个socket(通常每个EventLoop一个)bind同一个端口，由内核分散数据报，需要在bind之前设置
+    void setReusePort(bool on) { socket_.setReusePort(on); }
+    void setRecvBufferSize(int bytes) { socket_.setRecvBufferSize(bytes); }
+    void setSendBufferSize(int bytes) { socket_.setSendBufferSize(bytes); }
+
+    //以下两项需要在start()之前设置
+    //每次recvmmsg/sendmmsg最多处理的数据报个数
+    void setBatchSize(int batchSize);
+    //接收缓冲区的大小，更长的数据报被截断
+    void setMaxDatagramSize(size_t size);
+    //发送队列最多积压的数据报个数
+    void setMaxSendQueue(size_t maxSendQueue) { maxSendQueue_ = maxSendQueue; }
+
+    void setMessageCallback(const UdpMessageCallback& cb)
+    { messageCallback_ = cb; }
+
+    // must be called in loop thread
+    void start();
+    void stop();
+
+    // Thread safe.
+    // 在其他线程调用时data被拷贝一次再转交给IO线程
+    void send(const InetAddress& peer, const StringPiece& data);
+    // Thread safe.
+    // 按segmentSize切成多个数据报发送(UDP_SEGMENT)，最后一个可以较短
+    void sendSegmented(const InetAddress& peer, const StringPiece& data, uint16_t segmentSize);
+
+    size_t pendingDatagrams() const { return sendQueue_.size(); }
+    const UdpMetrics& metrics() const { return metrics_; }
+
+private:
+    struct Datagram
+    {
+        Datagram(const InetAddress& peerArg, uint16_t segmentSizeArg)
+          : peer(peerArg), segmentSize(segmentSizeArg)
+        { }
+
+        InetAddress peer;
+        std::string data;
+        uint16_t segmentSize;  // 0表示不使用GSO
+    };
+
+    /*
+    UdpSocket通常是UdpServer的成员，不由shared_ptr管理，
+    转交给loop的回调只持有self_的weak_ptr，socket析构之后回调什么也不做
+    */
+    typedef boost::shared_ptr<UdpSocket*> SelfPtr;
+    typedef boost::weak_ptr<UdpSocket*> WeakSelfPtr;
+    static void flushIfAlive(const WeakSelfPtr& weakSelf);
+    static void sendIfAlive(const WeakSelfPtr& weakSelf, const InetAddress& peer,
+                            const std::string& data, uint16_t segmentSize);
+
+    void handleRead(Timestamp receiveTime);
+    void handleWrite();
+    void enqueue(const InetAddress& peer, const char* data, size_t len, uint16_t segmentSize);
+    void flushInLoop();
+    //用sendmmsg发送队首最多batchSize_个数据报，返回发出的个数，-1表示出错
+    int sendBatch();
+    void allocateBuffers();
+
+    EventLoop* loop_;
+    Socket socket_;
+    Channel channel_;
+    UdpMessageCallback messageCallback_;
+    int batchSize_;
+    size_t maxDatagramSize_;
+    size_t maxSendQueue_;
+    bool started_;
+    bool flushPending_;
+    const SelfPtr self_;
+
+    //接收用的数组，start()时按batchSize_分配，之后一直复用
+    std::vector<char> recvBuffer_;  // batchSize_个maxDatagramSize_字节的缓冲区
+    std::vector<struct mmsghdr> recvMsgs_;
+    std::vector<struct iovec> recvIovecs_;
+    std::vector<struct sockaddr_storage> recvAddrs_;
+    //发送用的数组，同样复用
+    std::vector<struct mmsghdr> sendMsgs_;
+    std::vector<struct iovec> sendIovecs_;
+    std::vector<char> sendControl_;
+
+    std::deque<Datagram> sendQueue_;
+    UdpMetrics metrics_;
+};
+
+}//net
+}//muduo
+#endif
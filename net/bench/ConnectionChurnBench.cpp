@@ -0,0 +1,147 @@
+/*
+连接建立/断开的压力测试，统计每个连接的生命周期(accept、一次echo、关闭、销毁)平均分配几次堆内存。
+客户端线程只用系统调用，不分配内存，所以全局的operator new计数都来自服务端。
+单独编译：与base/、net/的源文件一起链接即可，例如
+g++ -std=c++11 -O2 -I. net/bench/ConnectionChurnBench.cpp $(find base net -maxdepth 1 -name '*.cpp') -lpthread
+用法：ConnectionChurnBench [connections] [port]
+*/
+#include "../EventLoop.h"
+#include "../InetAddress.h"
+#include "../TcpServer.h"
+#include "../../base/Logging.h"
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+std::atomic<int64_t> g_allocations(0);
+std::atomic<int64_t> g_allocatedBytes(0);
+}
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    g_allocatedBytes += size;
+    void* p = ::malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    ::free(p);
+}
+
+namespace
+{
+const int kMessageLen = 64;
+
+void onConnection(const TcpConnectionPtr&)
+{
+}
+
+void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    conn->send(buf);
+}
+
+//连接、发送、等回显、关闭，重复n次
+bool churn(uint16_t port, int n)
+{
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    char message[kMessageLen];
+    ::memset(message, 'x', sizeof message);
+    for (int i = 0; i < n; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) < 0)
+        {
+            perror("connect");
+            return false;
+        }
+        ssize_t nw = ::write(fd, message, sizeof message);
+        char reply[kMessageLen];
+        ssize_t nr = 0;
+        while (nw == kMessageLen && nr < kMessageLen)
+        {
+            ssize_t r = ::read(fd, reply + nr, sizeof reply - nr);
+            if (r <= 0)
+                break;
+            nr += r;
+        }
+        ::close(fd);
+        if (nr != kMessageLen)
+        {
+            fprintf(stderr, "echo failed at connection %d\n", i);
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const int connections = argc > 1 ? atoi(argv[1]) : 50000;
+    const uint16_t port = static_cast<uint16_t>(argc > 2 ? atoi(argv[2]) : 2016);
+    Logger::setLogLevel(Logger::WARN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port));
+    server.setConnectionCallback(onConnection);
+    server.setMessageCallback(onMessage);
+    server.start();
+
+    int64_t allocations = 0;
+    int64_t bytes = 0;
+    double seconds = 0;
+    bool ok = false;
+    std::thread client([&]()
+    {
+        //先跑一轮预热，让pool和各处的缓存达到稳态
+        ok = churn(port, connections / 10 + 1);
+        //等最后一个连接在服务端销毁
+        ::usleep(100 * 1000);
+        const int64_t allocs0 = g_allocations;
+        const int64_t bytes0 = g_allocatedBytes;
+        Timestamp start(Timestamp::now());
+        ok = ok && churn(port, connections);
+        ::usleep(100 * 1000);
+        seconds = timeDifference(Timestamp::now(), start) - 0.1;
+        allocations = g_allocations - allocs0;
+        bytes = g_allocatedBytes - bytes0;
+        loop.quit();
+    });
+    loop.loop();
+    client.join();
+    if (!ok)
+        return 1;
+    printf("%d connections in %.3f s, %.0f conn/s\n",
+           connections, seconds, connections / seconds);
+    printf("%.2f allocations, %.0f bytes per connection lifecycle\n",
+           static_cast<double>(allocations) / connections,
+           static_cast<double>(bytes) / connections);
+}
@@ -0,0 +1,276 @@
+/*
+统计TcpConnection::send()各个重载每次调用分配几次堆内存、分配了多少字节，
+分别在IO线程内和从其他线程调用。
+消息在计数开始前就准备好，计入的只有send()自身(以及跨线程时IO线程上执行的那部分)的分配；
+每次拷贝消息都要分配，所以分配的字节数接近消息长度就说明多拷贝了一次。
+客户端线程只用系统调用读走数据，不分配内存，数据都能直接写进socket而不进输出队列。
+单独编译：与base/、net/的源文件一起链接即可，例如
+g++ -std=c++11 -O2 -I. net/bench/SendAllocBench.cpp $(find base net -maxdepth 1 -name '*.cpp') -lpthread
+用法：SendAllocBench [messageSize] [sendsPerRound] [port]
+*/
+#include "../Buffer.h"
+#include "../EventLoop.h"
+#include "../InetAddress.h"
+#include "../TcpServer.h"
+#include "../../base/CountDownLatch.h"
+#include "../../base/Logging.h"
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+std::atomic<int64_t> g_allocations(0);
+std::atomic<int64_t> g_allocatedBytes(0);
+}
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    g_allocatedBytes += size;
+    void* p = ::malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    ::free(p);
+}
+
+namespace
+{
+enum Overload
+{
+    kConstString,
+    kRvalueString,
+    kStringPiece,
+    kRawPointer,
+    kBufferPtr,
+    kPayload,
+    kNumOverloads,
+};
+
+const char* const kOverloadNames[kNumOverloads] =
+{
+    "send(const std::string&)",
+    "send(std::string&&)",
+    "send(StringPiece)",
+    "send(const void*, size_t)",
+    "send(Buffer*)",
+    "send(PayloadPtr)",
+};
+
+//一轮要发送的消息，每种重载需要的形式都事先准备好
+struct Messages
+{
+    Messages(int n, size_t size)
+      : data(size, 'x'),
+        payload(boost::make_shared<std::string>(data))
+    {
+        strings.reserve(n);
+        buffers.resize(n);
+        for (int i = 0; i < n; ++i)
+        {
+            strings.push_back(data);
+            buffers[i].append(data);
+        }
+    }
+
+    std::string data;
+    PayloadPtr payload;
+    std::vector<std::string> strings;
+    std::vector<Buffer> buffers;
+};
+
+struct Counts
+{
+    int64_t allocations;
+    int64_t bytes;
+};
+
+Counts now()
+{
+    Counts c = { g_allocations, g_allocatedBytes };
+    return c;
+}
+
+void sendAll(const TcpConnectionPtr& conn, Overload overload, Messages* m)
+{
+    const int n = static_cast<int>(m->strings.size());
+    for (int i = 0; i < n; ++i)
+    {
+        switch (overload)
+        {
+        case kConstString:
+            conn->send(m->data);
+            break;
+        case kRvalueString:
+            conn->send(std::move(m->strings[i]));
+            break;
+        case kStringPiece:
+            conn->send(StringPiece(m->data.data(), static_cast<int>(m->data.size())));
+            break;
+        case kRawPointer:
+            conn->send(m->data.data(), m->data.size());
+            break;
+        case kBufferPtr:
+            conn->send(&m->buffers[i]);
+            break;
+        case kPayload:
+            conn->send(m->payload);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void sendInLoop(const TcpConnectionPtr& conn, Overload overload, Messages* m,
+                Counts* result, CountDownLatch* latch)
+{
+    Counts start(now());
+    sendAll(conn, overload, m);
+    Counts end(now());
+    result->allocations = end.allocations - start.allocations;
+    result->bytes = end.bytes - start.bytes;
+    latch->CountDown();
+}
+
+void countDown(CountDownLatch* latch)
+{
+    latch->CountDown();
+}
+
+//等IO线程执行完此前排队的所有函数
+void waitForLoop(EventLoop* loop)
+{
+    CountDownLatch latch(1);
+    loop->runInLoop(boost::bind(&countDown, &latch));
+    latch.wait();
+}
+
+TcpConnectionPtr g_conn;
+CountDownLatch g_connected(1);
+
+void onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        g_conn = conn;
+        g_connected.CountDown();
+    }
+}
+
+//读走服务端发来的所有数据，直到对方关闭
+void drain(uint16_t port)
+{
+    struct sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof addr) < 0)
+    {
+        perror("connect");
+        abort();
+    }
+    static char buf[256 * 1024];
+    while (::read(fd, buf, sizeof buf) > 0)
+    {
+    }
+    ::close(fd);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t messageSize = argc > 1 ? atoi(argv[1]) : 4096;
+    const int sends = argc > 2 ? atoi(argv[2]) : 256;
+    const uint16_t port = static_cast<uint16_t>(argc > 3 ? atoi(argv[3]) : 2017);
+    const int kRounds = 20;
+    Logger::setLogLevel(Logger::WARN);
+
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port));
+    server.setConnectionCallback(onConnection);
+    server.start();
+
+    std::thread client(boost::bind(&drain, port));
+    std::thread driver([&]()
+    {
+        g_connected.wait();
+        printf("%zu-byte messages, %d sends per round, %d rounds\n", messageSize, sends, kRounds);
+        printf("%-28s %14s %14s %14s %14s\n", "", "in-loop", "", "off-loop", "");
+        printf("%-28s %14s %14s %14s %14s\n", "overload",
+               "allocs/send", "bytes/send", "allocs/send", "bytes/send");
+        for (int o = 0; o < kNumOverloads; ++o)
+        {
+            Overload overload = static_cast<Overload>(o);
+            Counts inLoop = { 0, 0 };
+            Counts offLoop = { 0, 0 };
+            for (int round = 0; round < kRounds; ++round)
+            {
+                Messages m1(sends, messageSize);
+                Counts c;
+                CountDownLatch latch(1);
+                loop.runInLoop(boost::bind(&sendInLoop, g_conn, overload, &m1, &c, &latch));
+                latch.wait();
+                inLoop.allocations += c.allocations;
+                inLoop.bytes += c.bytes;
+
+                Messages m2(sends, messageSize);
+                waitForLoop(&loop);
+                Counts start(now());
+                sendAll(g_conn, overload, &m2);
+                //等IO线程把排队的发送都执行完，它们的分配也算在内，但不算waitForLoop自己的
+                CountDownLatch done(1);
+                Counts beforeWait(now());
+                loop.runInLoop(boost::bind(&countDown, &done));
+                Counts afterQueue(now());
+                done.wait();
+                Counts end(now());
+                offLoop.allocations += end.allocations - start.allocations
+                                       - (afterQueue.allocations - beforeWait.allocations);
+                offLoop.bytes += end.bytes - start.bytes
+                                 - (afterQueue.bytes - beforeWait.bytes);
+            }
+            const double n = static_cast<double>(sends) * kRounds;
+            printf("%-28s %14.2f %14.0f %14.2f %14.0f\n", kOverloadNames[o],
+                   inLoop.allocations / n, inLoop.bytes / n,
+                   offLoop.allocations / n, offLoop.bytes / n);
+        }
+        //等FIN发出去，客户端读到EOF后退出
+        g_conn->shutdown();
+        waitForLoop(&loop);
+        g_conn.reset();
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    client.join();
+}
@@ -0,0 +1,176 @@
+#include "HttpContext.h"
+
+#include "../Buffer.h"
+
+#include <algorithm>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t HttpContext::kMaxHeaderSize;
+const size_t HttpContext::kMaxBodySize;
+
+namespace
+{
+//只接受十进制数字，超过limit时返回false
+bool parseContentLength(const StringPiece& value, size_t limit, size_t* length)
+{
+    if (value.empty())
+    {
+        return false;
+    }
+    size_t result = 0;
+    for (const char* p = value.begin(); p != value.end(); ++p)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return false;
+        }
+        result = result * 10 + (*p - '0');
+        if (result > limit)
+        {
+            return false;
+        }
+    }
+    *length = result;
+    return true;
+}
+}
+
+//"GET /path?query HTTP/1.1"
+bool HttpContext::processRequestLine(const char* begin, const char* end)
+{
+    const char* start = begin;
+    const char* space = std::find(start, end, ' ');
+    if (space == end || !request_.setMethod(start, space))
+    {
+        return false;
+    }
+    start = space + 1;
+    space = std::find(start, end, ' ');
+    if (space == end || space == start)
+    {
+        return false;
+    }
+    const char* question = std::find(start, space, '?');
+    if (question != space)
+    {
+        request_.setPath(start, question);
+        request_.setQuery(question + 1, space);
+    }
+    else
+    {
+        request_.setPath(start, space);
+    }
+    start = space + 1;
+    if (end - start != 8 || !std::equal(start, end - 1, "HTTP/1."))
+    {
+        return false;
+    }
+    if (*(end - 1) == '1')
+    {
+        request_.setVersion(HttpRequest::kHttp11);
+    }
+    else if (*(end - 1) == '0')
+    {
+        request_.setVersion(HttpRequest::kHttp10);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+/*
+头部已经完整，逐行处理；不支持请求的chunked编码和已废弃的多行头部
+*/
+bool HttpContext::processHeaders(const char* begin, const char* end)
+{
+    const char* crlf = std::search(begin, end, "\r\n", "\r\n" + 2);
+    if (!processRequestLine(begin, crlf))
+    {
+        return false;
+    }
+    const char* line = crlf + 2;
+    while (line < end - 2)  // 最后是空行
+    {
+        crlf = std::search(line, end, "\r\n", "\r\n" + 2);
+        const char* colon = std::find(line, crlf, ':');
+        if (colon == crlf || colon == line || *line == ' ' || *line == '\t'
+            || colon[-1] == ' ' || colon[-1] == '\t')
+        {
+            return false;
+        }
+        request_.addHeader(line, colon, crlf);
+        line = crlf + 2;
+    }
+
+    if (!request_.getHeader("Transfer-Encoding").empty())
+    {
+        return false;
+    }
+    StringPiece contentLength = request_.getHeader("Content-Length");
+    bodyLength_ = 0;
+    if (!contentLength.empty()
+        && !parseContentLength(contentLength, kMaxBodySize, &bodyLength_))
+    {
+        return false;
+    }
+    return true;
+}
+
+bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
+{
+    if (state_ == kExpectHeaders)
+    {
+        const char* crlf = NULL;
+        while ((crlf = buf->findCRLF(buf->peek() + scanned_)) != NULL)
+        {
+            if (crlf == buf->peek() + lineStart_)
+            {
+                //请求行之前的空行，RFC 7230要求忽略
+                if (lineStart_ == 0)
+                {
+                    buf->retrieve(2);
+                    scanned_ = 0;
+                    continue;
+                }
+                headerLength_ = crlf + 2 - buf->peek();
+                break;
+            }
+            lineStart_ = crlf + 2 - buf->peek();
+            scanned_ = lineStart_;
+        }
+        if (crlf == NULL)
+        {
+            scanned_ = buf->readableBytes();
+            return scanned_ <= kMaxHeaderSize;
+        }
+        if (headerLength_ > kMaxHeaderSize
+            || !processHeaders(buf->peek(), buf->peek() + headerLength_))
+        {
+            return false;
+        }
+        base_ = buf->peek();
+        request_.setReceiveTime(receiveTime);
+        state_ = kExpectBody;
+    }
+    if (state_ == kExpectBody)
+    {
+        if (buf->readableBytes() < headerLength_ + bodyLength_)
+        {
+            return true;
+        }
+        if (buf->peek() != base_)
+        {
+            Timestamp t = request_.receiveTime();
+            request_.reset();
+            bool ok = processHeaders(buf->peek(), buf->peek() + headerLength_);
+            assert(ok); (void)ok;
+            request_.setReceiveTime(t);
+        }
+        request_.setBody(buf->peek() + headerLength_, bodyLength_);
+        state_ = kGotAll;
+    }
+    return true;
+}
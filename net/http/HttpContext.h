@@ -0,0 +1,102 @@
+/*
+每个HTTP连接一个，保存请求解析到哪一步，放在TcpConnection的context里
+*/
+#ifndef MUDUO_NET_HTTP_HTTPCONTEXT_H
+#define MUDUO_NET_HTTP_HTTPCONTEXT_H
+
+#include "../../base/copyable.h"
+#include "HttpRequest.h"
+#include "HttpStream.h"
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+
+///
+/// Incremental HTTP/1.x request parser.
+///
+/*
+数据不完整时记下已经扫描过的长度，下一次从那里继续找"\r\n"，不重复扫描。
+找到头部结尾的空行后才一次性解析请求行和各个头部，得到的都是指向buf的StringPiece；
+等body也到齐后，如果buf在这期间移动过(重新分配或者makeSpace)，就重新解析一遍头部，
+所以gotAll()时request()中的指针都是有效的。
+解析完成后请求仍然留在buf里，由使用者在处理完之后retrieve(requestLength())再reset()
+*/
+class HttpContext : public copyable
+{
+public:
+    enum HttpRequestParseState
+    {
+        kExpectHeaders,
+        kExpectBody,
+        kGotAll,
+    };
+
+    //请求行加头部的上限，超过时认为是错误的请求
+    static const size_t kMaxHeaderSize = 64*1024;
+    static const size_t kMaxBodySize = 16*1024*1024;
+
+    HttpContext()
+      : state_(kExpectHeaders),
+        scanned_(0),
+        lineStart_(0),
+        headerLength_(0),
+        bodyLength_(0),
+        base_(NULL)
+    {
+    }
+
+    // return false if any error
+    bool parseRequest(Buffer* buf, Timestamp receiveTime);
+
+    bool gotAll() const
+    { return state_ == kGotAll; }
+
+    //当前请求在buf中占用的字节数，gotAll()之后有效
+    size_t requestLength() const
+    { return headerLength_ + bodyLength_; }
+
+    void reset()
+    {
+        state_ = kExpectHeaders;
+        scanned_ = 0;
+        lineStart_ = 0;
+        headerLength_ = 0;
+        bodyLength_ = 0;
+        base_ = NULL;
+        request_.reset();
+    }
+
+    const HttpRequest& request() const
+    { return request_; }
+
+    HttpRequest& request()
+    { return request_; }
+
+    //正在发送的流式响应，发完之前不处理后面pipeline的请求，不受reset()影响
+    void setStream(const HttpStreamPtr& stream)
+    { stream_ = stream; }
+    const HttpStreamPtr& stream() const
+    { return stream_; }
+
+private:
+    //解析[begin, end)中的请求行和头部，end在空行之后
+    bool processHeaders(const char* begin, const char* end);
+    bool processRequestLine(const char* begin, const char* end);
+
+    HttpRequestParseState state_;
+    size_t scanned_;       // 已经找过"\r\n"的长度
+    size_t lineStart_;     // 当前这一行的起始偏移
+    size_t headerLength_;  // 包括结尾的空行
+    size_t bodyLength_;
+    const char* base_;     // 解析头部时buf->peek()的位置
+    HttpRequest request_;
+    HttpStreamPtr stream_;
+};
+
+}//net
+}//muduo
+#endif
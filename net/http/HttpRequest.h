@@ -0,0 +1,176 @@
+/*
+解析出的HTTP请求，各个字段都是指向TcpConnection输入缓冲区的StringPiece
+*/
+#ifndef MUDUO_NET_HTTP_HTTPREQUEST_H
+#define MUDUO_NET_HTTP_HTTPREQUEST_H
+
+#include "../../base/copyable.h"
+#include "../../base/StringPiece.h"
+#include "../../base/Timestamp.h"
+
+#include <utility>
+#include <vector>
+
+#include <assert.h>
+#include <ctype.h>
+#include <strings.h>  // strncasecmp
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// HTTP request, fields are views into the input Buffer.
+///
+/*
+不拷贝任何字符串，所以HttpRequest只在HttpCallback执行期间有效，
+需要保留的内容由用户自己拷贝。
+headers_用vector保存，HttpContext复用同一个HttpRequest，keep-alive连接上的后续请求不再分配内存
+*/
+class HttpRequest : public copyable
+{
+public:
+    enum Method
+    {
+        kInvalid, kGet, kPost, kHead, kPut, kDelete
+    };
+    enum Version
+    {
+        kUnknown, kHttp10, kHttp11
+    };
+    typedef std::pair<StringPiece, StringPiece> Header;
+    typedef std::vector<Header> HeaderList;
+
+    HttpRequest()
+      : method_(kInvalid),
+        version_(kUnknown)
+    {
+    }
+
+    void setVersion(Version v)
+    { version_ = v; }
+    Version getVersion() const
+    { return version_; }
+
+    bool setMethod(const char* start, const char* end)
+    {
+        assert(method_ == kInvalid);
+        StringPiece m(start, static_cast<int>(end - start));
+        if (m == "GET")
+            method_ = kGet;
+        else if (m == "POST")
+            method_ = kPost;
+        else if (m == "HEAD")
+            method_ = kHead;
+        else if (m == "PUT")
+            method_ = kPut;
+        else if (m == "DELETE")
+            method_ = kDelete;
+        else
+            method_ = kInvalid;
+        return method_ != kInvalid;
+    }
+    Method method() const
+    { return method_; }
+    const char* methodString() const
+    {
+        const char* result = "UNKNOWN";
+        switch (method_)
+        {
+            case kGet:
+                result = "GET";
+                break;
+            case kPost:
+                result = "POST";
+                break;
+            case kHead:
+                result = "HEAD";
+                break;
+            case kPut:
+                result = "PUT";
+                break;
+            case kDelete:
+                result = "DELETE";
+                break;
+            default:
+                break;
+        }
+        return result;
+    }
+
+    void setPath(const char* start, const char* end)
+    { path_.set(start, static_cast<int>(end - start)); }
+    const StringPiece& path() const
+    { return path_; }
+
+    void setQuery(const char* start, const char* end)
+    { query_.set(start, static_cast<int>(end - start)); }
+    const StringPiece& query() const
+    { return query_; }
+
+    void setReceiveTime(Timestamp t)
+    { receiveTime_ = t; }
+    Timestamp receiveTime() const
+    { return receiveTime_; }
+
+    //[start, colon)是字段名，(colon, end)是值，去掉值两边的空白
+    void addHeader(const char* start, const char* colon, const char* end)
+    {
+        const char* value = colon + 1;
+        while (value < end && isspace(static_cast<unsigned char>(*value)))
+        {
+            ++value;
+        }
+        while (end > value && isspace(static_cast<unsigned char>(end[-1])))
+        {
+            --end;
+        }
+        headers_.push_back(Header(StringPiece(start, static_cast<int>(colon - start)),
+                                  StringPiece(value, static_cast<int>(end - value))));
+    }
+    //字段名不区分大小写，没有这个字段时返回空的StringPiece
+    StringPiece getHeader(const StringPiece& field) const
+    {
+        for (HeaderList::const_iterator it = headers_.begin(); it != headers_.end(); ++it)
+        {
+            if (it->first.size() == field.size()
+                && ::strncasecmp(it->first.data(), field.data(), field.size()) == 0)
+            {
+                return it->second;
+            }
+        }
+        return StringPiece();
+    }
+    const HeaderList& headers() const
+    { return headers_; }
+
+    void setBody(const char* start, size_t len)
+    { body_.set(start, static_cast<int>(len)); }
+    const StringPiece& body() const
+    { return body_; }
+
+    //清空所有字段，保留headers_的容量
+    void reset()
+    {
+        method_ = kInvalid;
+        version_ = kUnknown;
+        path_.clear();
+        query_.clear();
+        body_.clear();
+        headers_.clear();
+    }
+
+private:
+    Method method_;
+    Version version_;
+    StringPiece path_;
+    StringPiece query_;
+    StringPiece body_;
+    Timestamp receiveTime_;
+    HeaderList headers_;
+};
+
+}//net
+}//muduo
+#endif
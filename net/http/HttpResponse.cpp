@@ -0,0 +1,82 @@
+#include "HttpResponse.h"
+
+#include "../Buffer.h"
+
+#include <stdio.h>  // snprintf
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+const char* defaultStatusMessage(int code)
+{
+    switch (code)
+    {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+void appendString(Buffer* output, const char* str)
+{
+    output->append(str, strlen(str));
+}
+}
+
+void HttpResponse::appendToBuffer(Buffer* output) const
+{
+    char buf[32];
+    snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
+    appendString(output, buf);
+    if (statusMessage_.empty())
+    {
+        appendString(output, defaultStatusMessage(statusCode_));
+    }
+    else
+    {
+        output->append(statusMessage_);
+    }
+    appendString(output, "\r\n");
+
+    if (closeConnection_)
+    {
+        appendString(output, "Connection: close\r\n");
+    }
+    else
+    {
+        appendString(output, "Connection: Keep-Alive\r\n");
+    }
+    if (!isStreaming())
+    {
+        snprintf(buf, sizeof buf, "Content-Length: %zu\r\n", body_.size());
+        appendString(output, buf);
+    }
+    else if (chunked_)
+    {
+        appendString(output, "Transfer-Encoding: chunked\r\n");
+    }
+
+    for (std::vector<Header>::const_iterator it = headers_.begin();
+         it != headers_.end();
+         ++it)
+    {
+        output->append(it->first);
+        appendString(output, ": ");
+        output->append(it->second);
+        appendString(output, "\r\n");
+    }
+
+    appendString(output, "\r\n");
+    if (!omitBody_ && !isStreaming())
+    {
+        output->append(body_);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+HTTP响应，由HttpServer序列化到输出缓冲区
+*/
+#ifndef MUDUO_NET_HTTP_HTTPRESPONSE_H
+#define MUDUO_NET_HTTP_HTTPRESPONSE_H
+
+#include "../../base/copyable.h"
+#include "HttpStream.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+
+class HttpResponse : public copyable
+{
+public:
+    enum HttpStatusCode
+    {
+        kUnknown,
+        k200Ok = 200,
+        k204NoContent = 204,
+        k301MovedPermanently = 301,
+        k400BadRequest = 400,
+        k404NotFound = 404,
+        k500InternalServerError = 500,
+        k503ServiceUnavailable = 503,
+    };
+
+    explicit HttpResponse(bool close)
+      : statusCode_(kUnknown),
+        closeConnection_(close),
+        omitBody_(false),
+        chunked_(true)
+    {
+    }
+
+    void setStatusCode(HttpStatusCode code)
+    { statusCode_ = code; }
+
+    //不设置时使用状态码对应的标准短语
+    void setStatusMessage(const std::string& message)
+    { statusMessage_ = message; }
+
+    void setCloseConnection(bool on)
+    { closeConnection_ = on; }
+
+    bool closeConnection() const
+    { return closeConnection_; }
+
+    void setContentType(const std::string& contentType)
+    { addHeader("Content-Type", contentType); }
+
+    // FIXME: replace std::string with StringPiece
+    void addHeader(const std::string& key, const std::string& value)
+    { headers_.push_back(Header(key, value)); }
+
+    void setBody(const std::string& body)
+    { body_ = body; }
+
+    /*
+    以下两种流式响应二选一，设置后忽略setBody()，改用chunked编码发送body，详见HttpStream
+    */
+    //输出队列每发完一次，HttpServer调用一次producer取下一段数据
+    void setBodyProducer(const HttpStream::BodyProducer& producer)
+    { producer_ = producer; }
+    //头部发出后，HttpServer把HttpStream交给cb，由用户自己写入数据
+    typedef boost::function<void (const HttpStreamPtr&)> StreamCallback;
+    void setStreamCallback(const StreamCallback& cb)
+    { streamCallback_ = cb; }
+    bool isStreaming() const
+    { return producer_ || streamCallback_; }
+    const HttpStream::BodyProducer& bodyProducer() const
+    { return producer_; }
+    const StreamCallback& streamCallback() const
+    { return streamCallback_; }
+
+    //HEAD请求的响应只有头部，Content-Length仍按body计算，由HttpServer设置
+    void setOmitBody(bool on)
+    { omitBody_ = on; }
+    //HTTP/1.0的客户端不认识chunked，HttpServer设为false，流式的body以关闭连接表示结束
+    void setChunked(bool on)
+    { chunked_ = on; }
+    bool chunked() const
+    { return chunked_; }
+
+    //状态行、头部和body直接追加到output，不经过中间的字符串
+    void appendToBuffer(Buffer* output) const;
+
+private:
+    typedef std::pair<std::string, std::string> Header;
+
+    std::vector<Header> headers_;
+    HttpStatusCode statusCode_;
+    // FIXME: add http version
+    std::string statusMessage_;
+    bool closeConnection_;
+    bool omitBody_;
+    bool chunked_;
+    std::string body_;
+    HttpStream::BodyProducer producer_;
+    StreamCallback streamCallback_;
+};
+
+}//net
+}//muduo
+#endif
@@ -0,0 +1,216 @@
+#include "HttpServer.h"
+
+#include "../../base/Logging.h"
+#include "../EventLoop.h"
+#include "HttpContext.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "HttpStream.h"
+
+#include <boost/bind.hpp>
+
+#include <strings.h>  // strncasecmp
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+void defaultHttpCallback(const HttpRequest&, HttpResponse* resp)
+{
+    resp->setStatusCode(HttpResponse::k404NotFound);
+    resp->setCloseConnection(true);
+}
+
+bool equalsIgnoreCase(const StringPiece& value, const char* expected)
+{
+    return value.size() == static_cast<int>(strlen(expected))
+        && ::strncasecmp(value.data(), expected, value.size()) == 0;
+}
+
+const char kBadRequest[] =
+    "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+}
+
+HttpServer::HttpServer(EventLoop* loop,
+                       const InetAddress& listenAddr,
+                       TcpServer::Option option)
+  : server_(loop, listenAddr, option),
+    httpCallback_(defaultHttpCallback)
+{
+    server_.setConnectionCallback(
+        boost::bind(&HttpServer::onConnection, this, _1));
+    server_.setMessageCallback(
+        boost::bind(&HttpServer::onMessage, this, _1, _2, _3));
+    server_.setWriteCompleteCallback(
+        boost::bind(&HttpServer::onWriteComplete, this, _1));
+}
+
+HttpServer::~HttpServer()
+{
+}
+
+void HttpServer::start()
+{
+    LOG_WARN << "HttpServer starts listenning";
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        conn->setContext(HttpContext());
+    }
+}
+void HttpServer::onMessage(const TcpConnectionPtr& conn,
+                           Buffer* buf,
+                           Timestamp receiveTime)
+{
+    HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
+    if (!conn->connected() || context == NULL)
+    {
+        buf->retrieveAll();
+        return;
+    }
+    //前一个流式响应还没发完，请求先留在buf里
+    if (context->stream())
+    {
+        return;
+    }
+    processRequests(conn, context, buf, receiveTime);
+}
+/*
+一次可能收到多个pipeline的请求，逐个处理直到数据不够一个完整请求，
+或者某个响应要求关闭连接为止，之后的请求都丢弃
+*/
+void HttpServer::processRequests(const TcpConnectionPtr& conn,
+                                 HttpContext* context,
+                                 Buffer* buf,
+                                 Timestamp receiveTime)
+{
+    Buffer output;
+    bool close = false;
+    while (!close && !context->stream())
+    {
+        if (!context->parseRequest(buf, receiveTime))
+        {
+            output.append(kBadRequest, sizeof kBadRequest - 1);
+            close = true;
+            break;
+        }
+        if (!context->gotAll())
+        {
+            break;
+        }
+        close = onRequest(conn, context, &output);
+        buf->retrieve(context->requestLength());
+        context->reset();
+    }
+    if (output.readableBytes() > 0)
+    {
+        conn->send(&output);
+    }
+    //流式响应要等body发完才关闭，见onStreamFinished
+    if (close && !context->stream())
+    {
+        buf->retrieveAll();
+        conn->shutdown();
+    }
+}
+
+bool HttpServer::onRequest(const TcpConnectionPtr& conn,
+                           HttpContext* context,
+                           Buffer* output)
+{
+    const HttpRequest& req = context->request();
+    StringPiece connection = req.getHeader("Connection");
+    bool close = equalsIgnoreCase(connection, "close") ||
+        (req.getVersion() == HttpRequest::kHttp10 && !equalsIgnoreCase(connection, "Keep-Alive"));
+    HttpResponse response(close);
+    if (req.method() == HttpRequest::kHead)
+    {
+        response.setOmitBody(true);
+    }
+    if (req.getVersion() == HttpRequest::kHttp10)
+    {
+        response.setChunked(false);
+    }
+    httpCallback_(req, &response);
+    const bool streaming = response.isStreaming() && req.method() != HttpRequest::kHead;
+    if (streaming && !response.chunked())
+    {
+        //没有chunked编码时只能以关闭连接表示body结束
+        response.setCloseConnection(true);
+    }
+    response.appendToBuffer(output);
+    if (streaming)
+    {
+        //之前的响应和这个响应的头部先发出去，body由HttpStream接着发
+        conn->send(output);
+        HttpStreamPtr stream(new HttpStream(conn, response.chunked()));
+        stream->setFinishCallback(
+            boost::bind(&HttpServer::onStreamFinished, this,
+                        boost::weak_ptr<TcpConnection>(conn), response.closeConnection()));
+        stream->setProducer(response.bodyProducer());
+        context->setStream(stream);
+        conn->stopRead();
+        if (response.streamCallback())
+        {
+            response.streamCallback()(stream);
+        }
+    }
+    return response.closeConnection();
+}
+/*
+拉取模式下，头部(以及之后每一段)发完时从这里取下一段body
+*/
+void HttpServer::onWriteComplete(const TcpConnectionPtr& conn)
+{
+    HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
+    if (context != NULL && context->stream())
+    {
+        HttpStreamPtr stream(context->stream());
+        stream->handleWriteComplete();
+    }
+}
+/*
+finish()可能在processRequests()内部(比如StreamCallback里)就被调用，
+这时当前请求还没从buf中取走，所以推迟到下一轮再继续处理后面的请求
+*/
+void HttpServer::onStreamFinished(const boost::weak_ptr<TcpConnection>& weakConn, bool close)
+{
+    TcpConnectionPtr conn(weakConn.lock());
+    if (conn)
+    {
+        conn->getLoop()->queueInLoop(
+            boost::bind(&HttpServer::resumeRequests, this, weakConn, close));
+    }
+}
+
+void HttpServer::resumeRequests(const boost::weak_ptr<TcpConnection>& weakConn, bool close)
+{
+    TcpConnectionPtr conn(weakConn.lock());
+    if (!conn)
+    {
+        return;
+    }
+    HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
+    if (context == NULL)
+    {
+        return;
+    }
+    context->setStream(HttpStreamPtr());
+    if (close)
+    {
+        conn->inputBuffer()->retrieveAll();
+        conn->shutdown();
+        return;
+    }
+    //流结束前对端可能已经断开，这时不能再关注可读事件
+    if (conn->connected())
+    {
+        conn->startRead();
+        processRequests(conn, context, conn->inputBuffer(), Timestamp::now());
+    }
+}
@@ -0,0 +1,79 @@
+/*
+基于TcpServer的HTTP/1.1服务器
+*/
+#ifndef MUDUO_NET_HTTP_HTTPSERVER_H
+#define MUDUO_NET_HTTP_HTTPSERVER_H
+
+#include "../../base/noncopyable.h"
+#include "../TcpServer.h"
+
+#include <boost/function.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class HttpContext;
+class HttpRequest;
+class HttpResponse;
+
+/// A simple embeddable HTTP server designed for report status of a program.
+/// It is not a fully HTTP 1.1 compliant server, but provides minimum features
+/// that can communicate with HttpClient and Web browser.
+/// It is synchronous, just like Java Servlet.
+/*
+支持keep-alive和pipeline：一次收到的多个请求按顺序逐个交给HttpCallback，
+它们的响应先追加到同一个Buffer，最后用一次send()交给TcpConnection，整块交换进输出队列。
+遇到流式响应(见HttpStream)时暂停：停止读取，后面的请求留在输入缓冲区里，
+等这个响应的body发完再继续处理，所以响应的顺序总是与请求一致。
+请求体只支持Content-Length，不支持chunked编码的请求
+*/
+class HttpServer : noncopyable
+{
+public:
+    typedef boost::function<void (const HttpRequest&,
+                                  HttpResponse*)> HttpCallback;
+
+    HttpServer(EventLoop* loop,
+               const InetAddress& listenAddr,
+               TcpServer::Option option = TcpServer::kNoReusePort);
+
+    ~HttpServer();  // force out-line dtor, for scoped_ptr members.
+
+    //用于设置空闲超时、连接数限制等
+    TcpServer* tcpServer() { return &server_; }
+
+    /// Not thread safe, callback be registered before calling start().
+    void setHttpCallback(const HttpCallback& cb)
+    {
+        httpCallback_ = cb;
+    }
+
+    void start();
+
+private:
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn,
+                   Buffer* buf,
+                   Timestamp receiveTime);
+    void onWriteComplete(const TcpConnectionPtr& conn);
+    //处理buf中所有完整的请求，直到需要关闭连接或者开始了一个流式响应
+    void processRequests(const TcpConnectionPtr& conn,
+                         HttpContext* context,
+                         Buffer* buf,
+                         Timestamp receiveTime);
+    //处理一个完整的请求，响应追加到output，返回是否需要关闭连接
+    bool onRequest(const TcpConnectionPtr& conn,
+                   HttpContext* context,
+                   Buffer* output);
+    void onStreamFinished(const boost::weak_ptr<TcpConnection>& weakConn, bool close);
+    void resumeRequests(const boost::weak_ptr<TcpConnection>& weakConn, bool close);
+
+    TcpServer server_;
+    HttpCallback httpCallback_;
+};
+
+}//net
+}//muduo
+#endif
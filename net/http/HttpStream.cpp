@@ -0,0 +1,175 @@
+#include "HttpStream.h"
+
+#include "../../base/Logging.h"
+#include "../Buffer.h"
+#include "../EventLoop.h"
+#include "../TcpConnection.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <stdio.h>  // snprintf
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+const double kMinPollDelay = 0.001;
+const double kMaxPollDelay = 0.1;
+}
+
+HttpStream::HttpStream(const TcpConnectionPtr& conn, bool chunked)
+  : conn_(conn),
+    chunked_(chunked),
+    finished_(false),
+    waiting_(false),
+    pollDelay_(kMinPollDelay)
+{
+}
+
+HttpStream::~HttpStream()
+{
+}
+/*
+长度不超过0xffffff时头部最多8字节，正好放进kCheapPrepend；
+预留区不够时(比如用户自己prepend过)头部单独发送
+*/
+bool HttpStream::write(Buffer* data)
+{
+    TcpConnectionPtr conn(conn_.lock());
+    if (!conn || finished_)
+    {
+        return false;
+    }
+    conn->getLoop()->assertInLoopThread();
+    const size_t len = data->readableBytes();
+    //长度为0的chunk表示结束，不能发出去
+    if (len == 0)
+    {
+        return true;
+    }
+    if (chunked_)
+    {
+        char header[32];
+        int n = snprintf(header, sizeof header, "%zx\r\n", len);
+        if (data->prependableBytes() >= static_cast<size_t>(n))
+        {
+            data->prepend(header, n);
+            data->append("\r\n", 2);
+            conn->send(data);
+        }
+        else
+        {
+            conn->send(header, n);
+            conn->send(data);
+            conn->send("\r\n", 2);
+        }
+    }
+    else
+    {
+        conn->send(data);
+    }
+    return true;
+}
+
+bool HttpStream::write(const StringPiece& data)
+{
+    Buffer buf;
+    buf.append(data.data(), data.size());
+    return write(&buf);
+}
+
+void HttpStream::finish()
+{
+    if (finished_)
+    {
+        return;
+    }
+    finished_ = true;
+    TcpConnectionPtr conn(conn_.lock());
+    if (conn && chunked_)
+    {
+        conn->send("0\r\n\r\n", 5);
+    }
+    if (finishCallback_)
+    {
+        finishCallback_();
+    }
+}
+
+size_t HttpStream::pendingBytes() const
+{
+    TcpConnectionPtr conn(conn_.lock());
+    return conn ? conn->pendingOutputBytes() : 0;
+}
+/*
+拉取模式下每次输出队列发完才取下一段，推送模式下通知用户可以继续写
+*/
+void HttpStream::handleWriteComplete()
+{
+    if (finished_)
+    {
+        return;
+    }
+    if (producer_)
+    {
+        Buffer chunk;
+        bool more = producer_(&chunk);
+        if (!more)
+        {
+            write(&chunk);
+            finish();
+        }
+        else if (chunk.readableBytes() > 0)
+        {
+            pollDelay_ = kMinPollDelay;
+            write(&chunk);
+        }
+        else
+        {
+            //没有数据也就不会再有WriteCompleteCallback，隔一段时间再取，间隔逐次翻倍
+            TcpConnectionPtr conn(conn_.lock());
+            if (conn)
+            {
+                LOG_TRACE << "HttpStream::handleWriteComplete - producer not ready, retry in "
+                          << pollDelay_ << "s";
+                waiting_ = true;
+                pollTimer_ = conn->getLoop()->runAfter(pollDelay_,
+                    boost::bind(&HttpStream::onPollTimer, shared_from_this()));
+                pollDelay_ = std::min(pollDelay_ * 2, kMaxPollDelay);
+            }
+        }
+    }
+    else if (drainCallback_)
+    {
+        drainCallback_(shared_from_this());
+    }
+}
+
+void HttpStream::onPollTimer()
+{
+    if (waiting_)
+    {
+        waiting_ = false;
+        handleWriteComplete();
+    }
+}
+
+void HttpStream::resume()
+{
+    if (!waiting_)
+    {
+        return;
+    }
+    TcpConnectionPtr conn(conn_.lock());
+    if (conn)
+    {
+        conn->getLoop()->assertInLoopThread();
+        conn->getLoop()->cancel(pollTimer_);
+    }
+    waiting_ = false;
+    pollDelay_ = kMinPollDelay;
+    handleWriteComplete();
+}
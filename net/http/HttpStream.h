@@ -0,0 +1,97 @@
+/*
+流式的HTTP响应body，用chunked编码分段发送
+*/
+#ifndef MUDUO_NET_HTTP_HTTPSTREAM_H
+#define MUDUO_NET_HTTP_HTTPSTREAM_H
+
+#include "../../base/noncopyable.h"
+#include "../../base/StringPiece.h"
+#include "../Callbacks.h"
+#include "../TimerId.h"
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+class HttpStream;
+typedef boost::shared_ptr<HttpStream> HttpStreamPtr;
+
+///
+/// Body of a streaming HTTP response.
+///
+/*
+有两种用法：
+拉取(pull)：HttpResponse::setBodyProducer()，连接的输出队列每发完一次(WriteCompleteCallback)
+调用一次producer取下一段数据，所以任何时候最多只有一段数据在内存里，导出大文件时内存有界；
+推送(push)：HttpResponse::setStreamCallback()，头部发出后把HttpStream交给用户，由用户write()/finish()，
+比如反向代理在上游连接的MessageCallback里直接write(buf)，上游的输入缓冲区被整块交换进下游的输出队列，不拷贝。
+推送方可以用pendingBytes()和DrainCallback做流量控制：积压太多时上游stopRead()，排空后再startRead()。
+write()把数据的长度(十六进制)写进Buffer的预留区，末尾追加"\r\n"，整段数据不移动。
+只持有连接的weak_ptr，连接断开后write()返回false。
+所有成员函数都必须在连接所在的loop线程调用
+*/
+class HttpStream : noncopyable,
+                   public boost::enable_shared_from_this<HttpStream>
+{
+public:
+    /*
+    往chunk里追加下一段数据，返回false表示这是最后一段。
+    返回true却没有数据表示数据源暂时没有数据：HttpStream隔一段时间(从1ms开始翻倍，最多100ms)再来取，
+    数据源也可以在有数据时调用resume()立即触发下一次拉取
+    */
+    typedef boost::function<bool (Buffer* chunk)> BodyProducer;
+    //连接的输出队列已经发完
+    typedef boost::function<void (const HttpStreamPtr&)> DrainCallback;
+
+    //chunked为false时(HTTP/1.0)直接发送数据，以关闭连接表示结束
+    HttpStream(const TcpConnectionPtr& conn, bool chunked);
+    ~HttpStream();
+
+    //把data中的全部数据作为一段发送，调用后data为空。连接已经断开或已经finish()时返回false
+    bool write(Buffer* data);
+    bool write(const StringPiece& data);
+    //发送表示结束的空chunk
+    void finish();
+    bool finished() const { return finished_; }
+
+    //连接输出队列中还没发出的字节数，连接已断开时为0
+    size_t pendingBytes() const;
+    TcpConnectionPtr connection() const { return conn_.lock(); }
+
+    void setDrainCallback(const DrainCallback& cb)
+    { drainCallback_ = cb; }
+
+    //拉取模式下producer没有数据时，数据源准备好后调用，立即再取一次。不在等待中时什么也不做
+    void resume();
+
+    // internal use only, called by HttpServer
+    void setProducer(const BodyProducer& producer)
+    { producer_ = producer; }
+    void setFinishCallback(const boost::function<void ()>& cb)
+    { finishCallback_ = cb; }
+    void handleWriteComplete();
+
+private:
+    void onPollTimer();
+
+    boost::weak_ptr<TcpConnection> conn_;
+    const bool chunked_;
+    bool finished_;
+    BodyProducer producer_;
+    DrainCallback drainCallback_;
+    boost::function<void ()> finishCallback_;
+    bool waiting_;        // producer暂时没有数据，等待定时器或resume()
+    double pollDelay_;    // 下一次等待的秒数
+    TimerId pollTimer_;
+};
+
+}//net
+}//muduo
+#endif
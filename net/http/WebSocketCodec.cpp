@@ -0,0 +1,399 @@
+#include "WebSocketCodec.h"
+
+#include "../Buffer.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t WebSocketCodec::kMaxControlPayload;
+const size_t WebSocketCodec::kMaxHeaderLen;
+
+namespace
+{
+typedef void (*UnmaskFunc)(char* p, size_t len, const char mask[4]);
+
+/*
+先按8字节一组异或，再逐字节处理剩下的不到8字节。
+每组的长度都是4的倍数，所以掩码的相位在组与组之间不变
+*/
+void unmaskScalar(char* p, size_t len, const char mask[4])
+{
+    uint32_t m32;
+    ::memcpy(&m32, mask, sizeof m32);
+    const uint64_t m64 = (static_cast<uint64_t>(m32) << 32) | m32;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t v;
+        ::memcpy(&v, p + i, sizeof v);
+        v ^= m64;
+        ::memcpy(p + i, &v, sizeof v);
+    }
+    for (; i < len; ++i)
+    {
+        p[i] = static_cast<char>(p[i] ^ mask[i & 3]);
+    }
+}
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+//x86是小端，set1_epi32把4字节掩码按内存顺序铺满整个寄存器
+void unmaskSse2(char* p, size_t len, const char mask[4])
+{
+    int32_t m32;
+    ::memcpy(&m32, mask, sizeof m32);
+    const __m128i m = _mm_set1_epi32(m32);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i* q = reinterpret_cast<__m128i*>(p + i);
+        _mm_storeu_si128(q, _mm_xor_si128(_mm_loadu_si128(q), m));
+    }
+    unmaskScalar(p + i, len - i, mask);
+}
+
+__attribute__((target("avx2")))
+void unmaskAvx2(char* p, size_t len, const char mask[4])
+{
+    int32_t m32;
+    ::memcpy(&m32, mask, sizeof m32);
+    const __m256i m = _mm256_set1_epi32(m32);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i* q = reinterpret_cast<__m256i*>(p + i);
+        _mm256_storeu_si256(q, _mm256_xor_si256(_mm256_loadu_si256(q), m));
+    }
+    unmaskSse2(p + i, len - i, mask);
+}
+
+UnmaskFunc selectUnmask()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return unmaskAvx2;
+    }
+    return unmaskSse2;
+}
+#else
+UnmaskFunc selectUnmask()
+{
+    return unmaskScalar;
+}
+#endif
+
+/*
+SHA-1只用于计算握手的Sec-WebSocket-Accept，输入是几十字节的短字符串
+*/
+class Sha1 : noncopyable
+{
+public:
+    Sha1()
+      : length_(0),
+        used_(0)
+    {
+        state_[0] = 0x67452301;
+        state_[1] = 0xEFCDAB89;
+        state_[2] = 0x98BADCFE;
+        state_[3] = 0x10325476;
+        state_[4] = 0xC3D2E1F0;
+    }
+
+    void update(const char* data, size_t len)
+    {
+        length_ += len;
+        while (len > 0)
+        {
+            size_t n = std::min(len, sizeof block_ - used_);
+            ::memcpy(block_ + used_, data, n);
+            used_ += n;
+            data += n;
+            len -= n;
+            if (used_ == sizeof block_)
+            {
+                transform();
+                used_ = 0;
+            }
+        }
+    }
+
+    void final(unsigned char digest[20])
+    {
+        const uint64_t bits = length_ * 8;
+        const unsigned char pad = 0x80;
+        update(reinterpret_cast<const char*>(&pad), 1);
+        const char zero = 0;
+        while (used_ != 56)
+        {
+            update(&zero, 1);
+        }
+        for (int i = 7; i >= 0; --i)
+        {
+            block_[used_++] = static_cast<unsigned char>(bits >> (i * 8));
+        }
+        transform();
+        for (int i = 0; i < 20; ++i)
+        {
+            digest[i] = static_cast<unsigned char>(state_[i / 4] >> (24 - (i % 4) * 8));
+        }
+    }
+
+private:
+    static uint32_t rol(uint32_t x, int n)
+    { return (x << n) | (x >> (32 - n)); }
+
+    void transform()
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i)
+        {
+            w[i] = (static_cast<uint32_t>(block_[i * 4]) << 24)
+                 | (static_cast<uint32_t>(block_[i * 4 + 1]) << 16)
+                 | (static_cast<uint32_t>(block_[i * 4 + 2]) << 8)
+                 | static_cast<uint32_t>(block_[i * 4 + 3]);
+        }
+        for (int i = 16; i < 80; ++i)
+        {
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3], e = state_[4];
+        for (int i = 0; i < 80; ++i)
+        {
+            uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        state_[0] += a;
+        state_[1] += b;
+        state_[2] += c;
+        state_[3] += d;
+        state_[4] += e;
+    }
+
+    uint32_t state_[5];
+    uint64_t length_;
+    unsigned char block_[64];
+    size_t used_;
+};
+
+std::string base64Encode(const unsigned char* data, size_t len)
+{
+    static const char kTable[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result;
+    result.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3)
+    {
+        uint32_t v = static_cast<uint32_t>(data[i]) << 16;
+        if (i + 1 < len)
+            v |= static_cast<uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < len)
+            v |= data[i + 2];
+        result += kTable[(v >> 18) & 0x3F];
+        result += kTable[(v >> 12) & 0x3F];
+        result += i + 1 < len ? kTable[(v >> 6) & 0x3F] : '=';
+        result += i + 2 < len ? kTable[v & 0x3F] : '=';
+    }
+    return result;
+}
+
+//帧头写到header中，返回长度
+size_t encodeHeader(char* header, WebSocketCodec::Opcode opcode, size_t len, bool fin)
+{
+    header[0] = static_cast<char>((fin ? 0x80 : 0) | opcode);
+    if (len < 126)
+    {
+        header[1] = static_cast<char>(len);
+        return 2;
+    }
+    else if (len <= 0xFFFF)
+    {
+        header[1] = 126;
+        header[2] = static_cast<char>(len >> 8);
+        header[3] = static_cast<char>(len);
+        return 4;
+    }
+    else
+    {
+        header[1] = 127;
+        const uint64_t len64 = len;
+        for (int i = 0; i < 8; ++i)
+        {
+            header[2 + i] = static_cast<char>(len64 >> ((7 - i) * 8));
+        }
+        return 10;
+    }
+}
+
+bool isControl(int opcode)
+{
+    return (opcode & 0x8) != 0;
+}
+
+bool isKnownOpcode(int opcode)
+{
+    return opcode == WebSocketCodec::kContinuation
+        || opcode == WebSocketCodec::kText
+        || opcode == WebSocketCodec::kBinary
+        || opcode == WebSocketCodec::kClose
+        || opcode == WebSocketCodec::kPing
+        || opcode == WebSocketCodec::kPong;
+}
+}
+
+void WebSocketCodec::unmask(char* data, size_t len, const char mask[4])
+{
+    //第一次调用时按CPU选定实现
+    static const UnmaskFunc func = selectUnmask();
+    func(data, len, mask);
+}
+/*
+先只看帧头：长度字段一到就能判断是否超过上限，不必等整个帧收齐，
+所以恶意的超长帧不会在输入缓冲区里堆积
+*/
+WebSocketCodec::ParseResult WebSocketCodec::parseFrame(Buffer* buf, size_t maxPayload, Frame* frame)
+{
+    const size_t readable = buf->readableBytes();
+    if (readable < 2)
+    {
+        return kIncomplete;
+    }
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(buf->peek());
+    const int opcode = p[0] & 0x0F;
+    const bool fin = (p[0] & 0x80) != 0;
+    //RSV位非0，或者客户端的帧没有掩码
+    if ((p[0] & 0x70) != 0 || (p[1] & 0x80) == 0 || !isKnownOpcode(opcode))
+    {
+        return kBadFrame;
+    }
+    uint64_t len = p[1] & 0x7F;
+    size_t headerLen = 2;
+    if (len == 126)
+    {
+        if (readable < 4)
+            return kIncomplete;
+        len = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+        headerLen = 4;
+    }
+    else if (len == 127)
+    {
+        if (readable < 10)
+            return kIncomplete;
+        len = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            len = (len << 8) | p[2 + i];
+        }
+        headerLen = 10;
+    }
+    if (isControl(opcode) && (!fin || len > kMaxControlPayload))
+    {
+        return kBadFrame;
+    }
+    if (len > maxPayload)
+    {
+        return kTooBig;
+    }
+    const char* mask = buf->peek() + headerLen;
+    headerLen += 4;
+    if (readable < headerLen + len)
+    {
+        return kIncomplete;
+    }
+    //peek()返回const指针，但数据属于buf，原地改写是安全的
+    char* payload = const_cast<char*>(buf->peek()) + headerLen;
+    unmask(payload, static_cast<size_t>(len), mask);
+    frame->fin = fin;
+    frame->opcode = static_cast<Opcode>(opcode);
+    frame->payload = payload;
+    frame->length = static_cast<size_t>(len);
+    frame->frameLength = headerLen + static_cast<size_t>(len);
+    return kComplete;
+}
+
+void WebSocketCodec::appendFrame(Buffer* out, Opcode opcode,
+                                 const char* data, size_t len, bool fin)
+{
+    char header[kMaxHeaderLen];
+    out->append(header, encodeHeader(header, opcode, len, fin));
+    out->append(data, len);
+}
+
+void WebSocketCodec::encodeFrame(Buffer* buf, Opcode opcode, bool fin)
+{
+    char header[kMaxHeaderLen];
+    const size_t headerLen = encodeHeader(header, opcode, buf->readableBytes(), fin);
+    if (buf->prependableBytes() >= headerLen)
+    {
+        buf->prepend(header, headerLen);
+    }
+    else
+    {
+        Buffer framed;
+        framed.append(header, headerLen);
+        framed.append(buf->peek(), buf->readableBytes());
+        buf->swap(framed);
+    }
+}
+
+PayloadPtr WebSocketCodec::makeFrame(Opcode opcode, const StringPiece& data)
+{
+    char header[kMaxHeaderLen];
+    const size_t headerLen = encodeHeader(header, opcode, data.size(), true);
+    boost::shared_ptr<std::string> frame(new std::string);
+    frame->reserve(headerLen + data.size());
+    frame->append(header, headerLen);
+    frame->append(data.data(), data.size());
+    return frame;
+}
+
+void WebSocketCodec::appendClosePayload(Buffer* out, uint16_t code, const StringPiece& reason)
+{
+    out->appendInt16(static_cast<int16_t>(code));
+    //整个payload不能超过控制帧的上限
+    const size_t n = std::min(static_cast<size_t>(reason.size()), kMaxControlPayload - 2);
+    out->append(reason.data(), n);
+}
+
+std::string WebSocketCodec::acceptKey(const StringPiece& clientKey)
+{
+    static const char kGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    Sha1 sha1;
+    sha1.update(clientKey.data(), clientKey.size());
+    sha1.update(kGuid, sizeof kGuid - 1);
+    unsigned char digest[20];
+    sha1.final(digest);
+    return base64Encode(digest, sizeof digest);
+}
@@ -0,0 +1,99 @@
+/*
+WebSocket(RFC 6455)的握手和帧编解码
+*/
+#ifndef MUDUO_NET_HTTP_WEBSOCKETCODEC_H
+#define MUDUO_NET_HTTP_WEBSOCKETCODEC_H
+
+#include "../../base/noncopyable.h"
+#include "../../base/StringPiece.h"
+#include "../Callbacks.h"
+
+#include <string>
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Buffer;
+
+///
+/// Stateless helpers for the WebSocket wire format.
+///
+/*
+只有静态函数，连接上的状态(分片、关闭握手)由WebSocketServer维护。
+解析时直接在输入缓冲区里就地去掉掩码，payload不拷贝；
+发送时帧头写进Buffer的kCheapPrepend预留区，不超过65535字节的payload不移动。
+不支持扩展(比如permessage-deflate)，RSV位必须为0
+*/
+class WebSocketCodec : noncopyable
+{
+public:
+    enum Opcode
+    {
+        kContinuation = 0x0,
+        kText = 0x1,
+        kBinary = 0x2,
+        kClose = 0x8,
+        kPing = 0x9,
+        kPong = 0xA,
+    };
+
+    enum CloseCode
+    {
+        kNormalClosure = 1000,
+        kGoingAway = 1001,
+        kProtocolError = 1002,
+        kUnsupportedData = 1003,
+        kNoStatus = 1005,         // 只用于本地表示，不能出现在close帧里
+        kMessageTooBig = 1009,
+    };
+
+    enum ParseResult
+    {
+        kComplete,      // 解析出一个完整的帧
+        kIncomplete,    // 数据不够一帧，buf不变
+        kBadFrame,      // 违反协议，应以kProtocolError关闭
+        kTooBig,        // payload超过上限，应以kMessageTooBig关闭
+    };
+
+    struct Frame
+    {
+        bool fin;
+        Opcode opcode;
+        const char* payload;   // 指向buf中已去掉掩码的数据
+        size_t length;         // payload的长度
+        size_t frameLength;    // 整个帧(含头部)的长度，处理完后retrieve这么多字节
+    };
+
+    //控制帧的payload不超过125字节
+    static const size_t kMaxControlPayload = 125;
+    //服务端发出的帧头最长10字节
+    static const size_t kMaxHeaderLen = 10;
+
+    //解析buf开头的一个客户端帧(必须带掩码)，payload在buf中就地去掉掩码
+    static ParseResult parseFrame(Buffer* buf, size_t maxPayload, Frame* frame);
+
+    //data[i] ^= mask[i % 4]，按CPU选用AVX2/SSE2实现
+    static void unmask(char* data, size_t len, const char mask[4]);
+
+    //把一个不带掩码的帧追加到out
+    static void appendFrame(Buffer* out, Opcode opcode,
+                            const char* data, size_t len, bool fin = true);
+    //buf中的全部数据作为一帧，帧头就地写在预留区；预留区不够时拷贝一次
+    static void encodeFrame(Buffer* buf, Opcode opcode, bool fin = true);
+    //编码成共享的只读帧，广播给多个连接时只编码一次
+    static PayloadPtr makeFrame(Opcode opcode, const StringPiece& data);
+    //close帧的payload：2字节状态码加上原因
+    static void appendClosePayload(Buffer* out, uint16_t code, const StringPiece& reason);
+
+    //握手响应中Sec-WebSocket-Accept的值
+    static std::string acceptKey(const StringPiece& clientKey);
+};
+
+}//net
+}//muduo
+#endif
@@ -0,0 +1,433 @@
+#include "WebSocketServer.h"
+
+#include "../../base/Logging.h"
+#include "../EventLoop.h"
+#include "HttpContext.h"
+#include "HttpRequest.h"
+
+#include <boost/bind.hpp>
+
+#include <vector>
+
+#include <ctype.h>
+#include <strings.h>  // strncasecmp
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t WebSocketServer::kDefaultMaxMessageSize;
+
+/*
+握手完成后保存在TcpConnection的context中，只在loop线程访问
+*/
+struct WebSocketServer::Session
+{
+    Session()
+      : closeSent(false),
+        fragmented(false),
+        binary(false)
+    { }
+
+    Timestamp lastReceive;  // 最近一次收到完整帧的时刻，ping定时器据此判断是否空闲
+    bool closeSent;         // 已经发出close帧，之后不再发送数据帧
+    bool fragmented;        // 正在接收一个分片的消息
+    bool binary;            // 分片消息的类型，由第一个分片决定
+    Buffer message;         // 分片消息拼接在这里
+};
+
+namespace
+{
+const char kBadRequest[] =
+    "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+
+//value是逗号分隔的列表，比如"keep-alive, Upgrade"，忽略大小写查找token
+bool containsToken(const StringPiece& value, const char* token)
+{
+    const int tokenLen = static_cast<int>(strlen(token));
+    const char* p = value.data();
+    const char* end = value.data() + value.size();
+    while (p < end)
+    {
+        while (p < end && (*p == ',' || isspace(static_cast<unsigned char>(*p))))
+            ++p;
+        const char* start = p;
+        while (p < end && *p != ',')
+            ++p;
+        const char* last = p;
+        while (last > start && isspace(static_cast<unsigned char>(last[-1])))
+            --last;
+        if (last - start == tokenLen && ::strncasecmp(start, token, tokenLen) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+WebSocketServer::WebSocketServer(EventLoop* loop,
+                                 const InetAddress& listenAddr,
+                                 TcpServer::Option option)
+  : loop_(loop),
+    server_(loop, listenAddr, option),
+    maxMessageSize_(kDefaultMaxMessageSize),
+    pingInterval_(30.0),
+    pingTimeout_(60.0),
+    closeTimeout_(5.0),
+    pingFrame_(WebSocketCodec::makeFrame(WebSocketCodec::kPing, StringPiece()))
+{
+    server_.setConnectionCallback(
+        boost::bind(&WebSocketServer::onConnection, this, _1));
+    server_.setMessageCallback(
+        boost::bind(&WebSocketServer::onMessage, this, _1, _2, _3));
+}
+
+WebSocketServer::~WebSocketServer()
+{
+    //ping定时器的回调绑定的是this
+    loop_->cancel(pingTimer_);
+}
+
+void WebSocketServer::start()
+{
+    LOG_WARN << "WebSocketServer starts listenning";
+    server_.start();
+    if (pingInterval_ > 0.0)
+    {
+        pingTimer_ = loop_->runEvery(pingInterval_, boost::bind(&WebSocketServer::onPingTimer, this));
+    }
+}
+
+void WebSocketServer::onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        conn->setContext(HttpContext());
+    }
+    else if (connections_.erase(conn->id()) > 0 && closeCallback_)
+    {
+        closeCallback_(conn);
+    }
+}
+
+void WebSocketServer::onMessage(const TcpConnectionPtr& conn,
+                                Buffer* buf,
+                                Timestamp receiveTime)
+{
+    if (!conn->connected())
+    {
+        buf->retrieveAll();
+        return;
+    }
+    Session* session = boost::any_cast<Session>(conn->getMutableContext());
+    if (session == NULL)
+    {
+        if (!handshake(conn, buf, receiveTime))
+        {
+            return;
+        }
+        session = boost::any_cast<Session>(conn->getMutableContext());
+        assert(session != NULL);
+    }
+    processFrames(conn, session, buf, receiveTime);
+}
+/*
+升级请求之后客户端可能紧接着就发了帧，所以只retrieve请求本身，剩下的数据按帧处理
+*/
+bool WebSocketServer::handshake(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+{
+    HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());
+    if (context == NULL)
+    {
+        buf->retrieveAll();
+        return false;
+    }
+    bool ok = context->parseRequest(buf, receiveTime);
+    if (ok && !context->gotAll())
+    {
+        return false;
+    }
+    std::string accept;
+    if (ok)
+    {
+        const HttpRequest& req = context->request();
+        const StringPiece key = req.getHeader("Sec-WebSocket-Key");
+        ok = req.method() == HttpRequest::kGet
+            && req.getVersion() == HttpRequest::kHttp11
+            && containsToken(req.getHeader("Upgrade"), "websocket")
+            && containsToken(req.getHeader("Connection"), "upgrade")
+            && req.getHeader("Sec-WebSocket-Version") == "13"
+            && !key.empty()
+            && (!handshakeCallback_ || handshakeCallback_(req));
+        if (ok)
+        {
+            accept = WebSocketCodec::acceptKey(key);
+        }
+    }
+    if (!ok)
+    {
+        LOG_INFO << "WebSocketServer::handshake [" << conn->name() << "] - rejected";
+        conn->send(kBadRequest, sizeof kBadRequest - 1);
+        buf->retrieveAll();
+        conn->shutdown();
+        return false;
+    }
+    Buffer response;
+    response.append("HTTP/1.1 101 Switching Protocols\r\n"
+                    "Upgrade: websocket\r\n"
+                    "Connection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: ");
+    response.append(accept);
+    response.append("\r\n\r\n");
+    conn->send(&response);
+    buf->retrieve(context->requestLength());
+
+    //setContext之后context和request都失效了
+    Session session;
+    session.lastReceive = receiveTime;
+    conn->setContext(session);
+    connections_[conn->id()] = conn;
+    if (openCallback_)
+    {
+        openCallback_(conn);
+    }
+    return true;
+}
+/*
+一次可能收到多个帧，逐个处理；未分片的消息直接把buf中的payload交给回调，不拷贝
+*/
+void WebSocketServer::processFrames(const TcpConnectionPtr& conn, Session* session,
+                                    Buffer* buf, Timestamp receiveTime)
+{
+    while (true)
+    {
+        WebSocketCodec::Frame frame;
+        WebSocketCodec::ParseResult result =
+            WebSocketCodec::parseFrame(buf, maxMessageSize_, &frame);
+        if (result == WebSocketCodec::kIncomplete)
+        {
+            break;
+        }
+        if (result != WebSocketCodec::kComplete)
+        {
+            LOG_ERROR << "WebSocketServer::processFrames [" << conn->name()
+                      << "] - bad frame";
+            buf->retrieveAll();
+            sendClose(conn, session,
+                      result == WebSocketCodec::kTooBig
+                          ? WebSocketCodec::kMessageTooBig : WebSocketCodec::kProtocolError,
+                      StringPiece());
+            conn->forceCloseWithDelay(closeTimeout_);
+            break;
+        }
+        session->lastReceive = receiveTime;
+        if (!onFrame(conn, session, frame, receiveTime))
+        {
+            buf->retrieveAll();
+            break;
+        }
+        buf->retrieve(frame.frameLength);
+    }
+}
+
+bool WebSocketServer::onFrame(const TcpConnectionPtr& conn, Session* session,
+                              const WebSocketCodec::Frame& frame, Timestamp receiveTime)
+{
+    uint16_t errorCode = WebSocketCodec::kProtocolError;
+    switch (frame.opcode)
+    {
+    case WebSocketCodec::kText:
+    case WebSocketCodec::kBinary:
+        if (session->fragmented)
+        {
+            break;
+        }
+        if (frame.fin)
+        {
+            if (!session->closeSent && messageCallback_)
+            {
+                messageCallback_(conn,
+                                 StringPiece(frame.payload, static_cast<int>(frame.length)),
+                                 frame.opcode == WebSocketCodec::kBinary,
+                                 receiveTime);
+            }
+        }
+        else
+        {
+            session->fragmented = true;
+            session->binary = frame.opcode == WebSocketCodec::kBinary;
+            session->message.append(frame.payload, frame.length);
+        }
+        return true;
+
+    case WebSocketCodec::kContinuation:
+        if (!session->fragmented)
+        {
+            break;
+        }
+        if (session->message.readableBytes() + frame.length > maxMessageSize_)
+        {
+            errorCode = WebSocketCodec::kMessageTooBig;
+            break;
+        }
+        session->message.append(frame.payload, frame.length);
+        if (frame.fin)
+        {
+            session->fragmented = false;
+            if (!session->closeSent && messageCallback_)
+            {
+                messageCallback_(conn,
+                                 StringPiece(session->message.peek(),
+                                             static_cast<int>(session->message.readableBytes())),
+                                 session->binary,
+                                 receiveTime);
+            }
+            session->message.retrieveAll();
+        }
+        return true;
+
+    case WebSocketCodec::kPing:
+        if (!session->closeSent)
+        {
+            Buffer pong;
+            WebSocketCodec::appendFrame(&pong, WebSocketCodec::kPong, frame.payload, frame.length);
+            conn->send(&pong);
+        }
+        return true;
+
+    case WebSocketCodec::kPong:
+        return true;
+
+    case WebSocketCodec::kClose:
+        //状态码是2个字节，只有1个字节的payload不合法
+        if (frame.length == 1)
+        {
+            break;
+        }
+        if (session->closeSent)
+        {
+            //我们先发起的关闭，这就是对方的回应，握手完成，立即关闭TCP连接
+            conn->forceClose();
+        }
+        else
+        {
+            /*
+            对方先发起的关闭，按原状态码回应。RFC 6455 7.1.1要求服务端先关闭TCP连接：
+            回应写完后shutdown()立即发出FIN；对方一直不关闭它那一半时，
+            由forceCloseWithDelay的定时器释放fd和缓冲区
+            */
+            uint16_t code = WebSocketCodec::kNoStatus;
+            if (frame.length >= 2)
+            {
+                code = static_cast<uint16_t>(
+                    (static_cast<unsigned char>(frame.payload[0]) << 8)
+                    | static_cast<unsigned char>(frame.payload[1]));
+            }
+            sendClose(conn, session, code, StringPiece());
+            conn->shutdown();
+            conn->forceCloseWithDelay(closeTimeout_);
+        }
+        return false;
+
+    default:
+        break;
+    }
+    LOG_ERROR << "WebSocketServer::onFrame [" << conn->name()
+              << "] - protocol error, opcode " << frame.opcode;
+    sendClose(conn, session, errorCode, StringPiece());
+    conn->forceCloseWithDelay(closeTimeout_);
+    return false;
+}
+
+void WebSocketServer::sendClose(const TcpConnectionPtr& conn, Session* session,
+                                uint16_t code, const StringPiece& reason)
+{
+    if (session->closeSent)
+    {
+        return;
+    }
+    session->closeSent = true;
+    Buffer buf;
+    if (code != WebSocketCodec::kNoStatus)
+    {
+        WebSocketCodec::appendClosePayload(&buf, code, reason);
+    }
+    WebSocketCodec::encodeFrame(&buf, WebSocketCodec::kClose);
+    conn->send(&buf);
+}
+
+void WebSocketServer::sendText(const TcpConnectionPtr& conn, const StringPiece& message)
+{
+    Buffer buf;
+    buf.append(message.data(), message.size());
+    send(conn, &buf, false);
+}
+
+void WebSocketServer::sendBinary(const TcpConnectionPtr& conn, const StringPiece& message)
+{
+    Buffer buf;
+    buf.append(message.data(), message.size());
+    send(conn, &buf, true);
+}
+
+void WebSocketServer::send(const TcpConnectionPtr& conn, Buffer* buf, bool binary)
+{
+    WebSocketCodec::encodeFrame(buf, binary ? WebSocketCodec::kBinary : WebSocketCodec::kText);
+    conn->send(buf);
+}
+
+void WebSocketServer::close(const TcpConnectionPtr& conn, uint16_t code, const StringPiece& reason)
+{
+    conn->getLoop()->runInLoop(
+        boost::bind(&WebSocketServer::closeInLoop, this, conn, code, reason.as_string()));
+}
+/*
+发出close帧后就关闭写端，对方的close帧仍然可以读到，收到后在onFrame中立即关闭；
+对方迟迟不回应时由forceCloseWithDelay的定时器兜底
+*/
+void WebSocketServer::closeInLoop(const TcpConnectionPtr& conn, uint16_t code, const std::string& reason)
+{
+    loop_->assertInLoopThread();
+    Session* session = boost::any_cast<Session>(conn->getMutableContext());
+    if (session == NULL || session->closeSent)
+    {
+        return;
+    }
+    sendClose(conn, session, code, StringPiece(reason.data(), static_cast<int>(reason.size())));
+    conn->shutdown();
+    conn->forceCloseWithDelay(closeTimeout_);
+}
+/*
+只给空闲的连接发ping：最近收到过数据的连接显然还活着，不必多发一帧。
+要关闭的连接先收集起来，遍历完再关闭，不在遍历中修改connections_
+*/
+void WebSocketServer::onPingTimer()
+{
+    loop_->assertInLoopThread();
+    const Timestamp now = Timestamp::now();
+    std::vector<TcpConnectionPtr> expired;
+    for (ConnectionMap::iterator it = connections_.begin(); it != connections_.end(); ++it)
+    {
+        const TcpConnectionPtr& conn = it->second;
+        Session* session = boost::any_cast<Session>(conn->getMutableContext());
+        if (session == NULL || session->closeSent || !conn->connected())
+        {
+            continue;
+        }
+        const double idle = timeDifference(now, session->lastReceive);
+        if (idle >= pingTimeout_)
+        {
+            expired.push_back(conn);
+        }
+        else if (idle >= pingInterval_)
+        {
+            conn->send(pingFrame_);
+        }
+    }
+    for (size_t i = 0; i < expired.size(); ++i)
+    {
+        LOG_INFO << "WebSocketServer::onPingTimer [" << expired[i]->name()
+                 << "] - no pong in " << pingTimeout_ << " seconds";
+        expired[i]->forceClose();
+    }
+}
@@ -0,0 +1,132 @@
+/*
+基于TcpServer的WebSocket服务器
+*/
+#ifndef MUDUO_NET_HTTP_WEBSOCKETSERVER_H
+#define MUDUO_NET_HTTP_WEBSOCKETSERVER_H
+
+#include "../../base/noncopyable.h"
+#include "../../base/StringPiece.h"
+#include "../TcpServer.h"
+#include "../TimerId.h"
+#include "WebSocketCodec.h"
+
+#include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class HttpRequest;
+
+///
+/// WebSocket server, RFC 6455 without extensions.
+///
+/*
+连接先按HTTP解析升级请求(HttpContext)，握手成功后连接的context换成WebSocket的状态。
+MessageCallback收到的message直接指向输入缓冲区中已去掉掩码的payload，只在回调期间有效；
+只有分片的消息才会拷贝到单独的Buffer里拼接。
+所有连接共用一个runEvery定时器：空闲超过pingInterval的连接发一个ping，
+超过pingTimeout仍没有收到任何帧(包括pong)的连接直接关闭。
+不校验文本消息的UTF-8编码，留给应用处理
+*/
+class WebSocketServer : noncopyable
+{
+public:
+    //返回false拒绝握手(比如path不对)，回复400
+    typedef boost::function<bool (const HttpRequest&)> HandshakeCallback;
+    //握手完成或者已经握手的连接断开时调用
+    typedef boost::function<void (const TcpConnectionPtr&)> WebSocketConnectionCallback;
+    typedef boost::function<void (const TcpConnectionPtr&,
+                                  const StringPiece& message,
+                                  bool binary,
+                                  Timestamp)> WebSocketMessageCallback;
+
+    static const size_t kDefaultMaxMessageSize = 16*1024*1024;
+
+    WebSocketServer(EventLoop* loop,
+                    const InetAddress& listenAddr,
+                    TcpServer::Option option = TcpServer::kNoReusePort);
+    ~WebSocketServer();
+
+    //用于设置空闲超时、连接数限制等
+    TcpServer* tcpServer() { return &server_; }
+
+    /// Not thread safe, callbacks be registered before calling start().
+    void setHandshakeCallback(const HandshakeCallback& cb)
+    { handshakeCallback_ = cb; }
+    void setOpenCallback(const WebSocketConnectionCallback& cb)
+    { openCallback_ = cb; }
+    void setCloseCallback(const WebSocketConnectionCallback& cb)
+    { closeCallback_ = cb; }
+    void setMessageCallback(const WebSocketMessageCallback& cb)
+    { messageCallback_ = cb; }
+
+    //单个消息(分片拼接后)的上限，超过时以1009关闭
+    void setMaxMessageSize(size_t bytes)
+    { maxMessageSize_ = bytes; }
+    //需要在start()之前设置，interval<=0表示不发ping
+    void setPingInterval(double interval, double timeout)
+    { pingInterval_ = interval; pingTimeout_ = timeout; }
+    //发出close帧后等待对方回应的时间，超时强制关闭
+    void setCloseTimeout(double seconds)
+    { closeTimeout_ = seconds; }
+
+    void start();
+
+    //以下发送函数是线程安全的，只能用于握手完成的连接
+    static void sendText(const TcpConnectionPtr& conn, const StringPiece& message);
+    static void sendBinary(const TcpConnectionPtr& conn, const StringPiece& message);
+    //buf中的全部数据作为一个消息，帧头写在预留区，发送后buf为空
+    static void send(const TcpConnectionPtr& conn, Buffer* buf, bool binary);
+    //发送WebSocketCodec::makeFrame()编好的帧，广播时所有连接共享同一份数据
+    static void sendFrame(const TcpConnectionPtr& conn, const PayloadPtr& frame)
+    { conn->send(frame); }
+
+    //发起关闭握手
+    void close(const TcpConnectionPtr& conn,
+               uint16_t code = WebSocketCodec::kNormalClosure,
+               const StringPiece& reason = StringPiece());
+
+private:
+    struct Session;
+
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn,
+                   Buffer* buf,
+                   Timestamp receiveTime);
+    //处理升级请求，成功返回true
+    bool handshake(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+    void processFrames(const TcpConnectionPtr& conn, Session* session,
+                       Buffer* buf, Timestamp receiveTime);
+    //处理一个完整的帧，返回false表示不再处理后面的数据
+    bool onFrame(const TcpConnectionPtr& conn, Session* session,
+                 const WebSocketCodec::Frame& frame, Timestamp receiveTime);
+    void closeInLoop(const TcpConnectionPtr& conn, uint16_t code, const std::string& reason);
+    //发送close帧，没发过才发
+    void sendClose(const TcpConnectionPtr& conn, Session* session,
+                   uint16_t code, const StringPiece& reason);
+    void onPingTimer();
+
+    //握手完成的连接，供ping定时器遍历
+    typedef boost::unordered_map<uint64_t, TcpConnectionPtr> ConnectionMap;
+
+    EventLoop* loop_;
+    TcpServer server_;
+    HandshakeCallback handshakeCallback_;
+    WebSocketConnectionCallback openCallback_;
+    WebSocketConnectionCallback closeCallback_;
+    WebSocketMessageCallback messageCallback_;
+    size_t maxMessageSize_;
+    double pingInterval_;
+    double pingTimeout_;
+    double closeTimeout_;
+    TimerId pingTimer_;
+    ConnectionMap connections_;
+    const PayloadPtr pingFrame_;
+};
+
+}//net
+}//muduo
+#endif